@@ -0,0 +1,198 @@
+/*
+ * This file is licensed under the Mozilla Public License, v. 2.0.
+ * You can obtain a copy of the license at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "Benchmark.h"
+
+#include <algorithm>
+#include <numeric>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+#include <utility>		// std::move
+
+namespace
+{
+	int count_arg(const std::string& option, const std::string& value, int min_count)
+	{
+		std::size_t pos = 0;
+		int n = 0;
+		try
+		{
+			n = std::stoi(value, &pos);
+		}
+		catch (const std::exception&)
+		{
+			pos = 0;
+		}
+
+		if (pos != value.size() || n < min_count)
+		{
+			throw std::invalid_argument{"Invalid value for " + option + ": " + value};
+		}
+		return n;
+	}
+
+	std::string compiler_id()
+	{
+#if defined(__clang__)
+		return "Clang " __clang_version__;
+#elif defined(__GNUC__)
+		return "GCC " __VERSION__;
+#elif defined(_MSC_VER)
+		return "MSVC " + std::to_string(_MSC_FULL_VER);
+#else
+		return "unknown";
+#endif
+	}
+
+	// Benchmark names and units are plain identifiers, but the compiler
+	// version string may contain quotes:
+	std::string json_string(const std::string& s)
+	{
+		std::string quoted{"\""};
+		for (char c : s)
+		{
+			if (c == '"' || c == '\\') quoted += '\\';
+			quoted += c;
+		}
+		return quoted + "\"";
+	}
+
+	// JSON has no representation of NaN or infinity:
+	std::string json_number(double x)
+	{
+		if (!std::isfinite(x)) return "null";
+		std::ostringstream oss;
+		oss << std::setprecision(17) << x;
+		return oss.str();
+	}
+}
+
+BenchmarkOptions BenchmarkOptions::from_args(int argc, char* argv[])
+{
+	BenchmarkOptions options{};
+	for (int i = 1; i < argc; ++i)
+	{
+		const std::string option{argv[i]};
+		if (i + 1 == argc)
+		{
+			throw std::invalid_argument{"Missing value for option " + option};
+		}
+		const std::string value{argv[++i]};
+
+		if (option == "--warmup") options.warmup_runs = count_arg(option, value, 0);
+		else if (option == "--reps") options.repetitions = count_arg(option, value, 1);
+		else if (option == "--filter") options.filter = value;
+		else if (option == "--json") options.json_file = value;
+		else throw std::invalid_argument{"Unknown option " + option};
+	}
+
+	return options;
+}
+
+double BenchmarkResult::items_per_second() const
+{
+	return (items_per_run > 0.0 && median_ms > 0.0) ? 1000.0 * items_per_run / median_ms : 0.0;
+}
+
+BenchmarkSuite::BenchmarkSuite(std::string suite_name, BenchmarkOptions options) :
+	suite_name_{std::move(suite_name)}, options_{std::move(options)} {}
+
+const std::vector<BenchmarkResult>& BenchmarkSuite::results() const
+{
+	return results_;
+}
+
+bool BenchmarkSuite::selected_(const std::string& name) const
+{
+	return options_.filter.empty() || name.find(options_.filter) != std::string::npos;
+}
+
+void BenchmarkSuite::add_result_(const std::string& name, std::vector<double> times_ms,
+	double items_per_run, const std::string& item_unit, double result)
+{
+	std::ranges::sort(times_ms);
+	const std::size_t n = times_ms.size();
+
+	// Median, and the nearest-rank 99th percentile (the maximum, for fewer
+	// than 100 runs):
+	const double median = (n % 2 == 1) ? times_ms[n / 2]
+		: 0.5 * (times_ms[n / 2 - 1] + times_ms[n / 2]);
+	const auto p99_rank = static_cast<std::size_t>(std::ceil(0.99 * n));
+
+	results_.push_back(BenchmarkResult{name, static_cast<int>(n), median,
+		times_ms[p99_rank - 1], times_ms.front(),
+		std::accumulate(times_ms.begin(), times_ms.end(), 0.0) / n,
+		items_per_run, item_unit, result});
+
+	const auto& res = results_.back();
+	std::cout << std::left << std::setw(32) << name << std::right << std::fixed
+		<< std::setprecision(3) << std::setw(12) << res.median_ms << " ms (median)"
+		<< std::setw(12) << res.p99_ms << " ms (p99)";
+	if (items_per_run > 0.0)
+	{
+		std::cout << std::setprecision(0) << std::setw(16) << res.items_per_second()
+			<< " " << item_unit << "/sec";
+	}
+	std::cout << "\n";
+}
+
+void BenchmarkSuite::report(std::ostream& os) const
+{
+	os << "\n" << suite_name_ << ": " << results_.size() << " benchmarks, "
+		<< options_.warmup_runs << " warm-up and " << options_.repetitions
+		<< " timed runs each, " << compiler_id() << "\n";
+
+	if (!options_.json_file.empty())
+	{
+		std::ofstream json{options_.json_file};
+		if (!json)
+		{
+			throw std::runtime_error{"Cannot open " + options_.json_file + " for writing"};
+		}
+		write_json(json);
+		os << "Results written to " << options_.json_file << "\n";
+	}
+}
+
+void BenchmarkSuite::write_json(std::ostream& os) const
+{
+#ifdef NDEBUG
+	constexpr bool ndebug = true;
+#else
+	constexpr bool ndebug = false;
+#endif
+
+	os << "{\n"
+		<< "  \"suite\": " << json_string(suite_name_) << ",\n"
+		<< "  \"compiler\": " << json_string(compiler_id()) << ",\n"
+		<< "  \"cplusplus\": " << __cplusplus << ",\n"
+		<< "  \"ndebug\": " << (ndebug ? "true" : "false") << ",\n"
+		<< "  \"hardware_threads\": " << std::thread::hardware_concurrency() << ",\n"
+		<< "  \"warmup_runs\": " << options_.warmup_runs << ",\n"
+		<< "  \"repetitions\": " << options_.repetitions << ",\n"
+		<< "  \"benchmarks\": [";
+
+	for (std::size_t i = 0; i < results_.size(); ++i)
+	{
+		const auto& res = results_[i];
+		os << (i == 0 ? "\n" : ",\n")
+			<< "    {\"name\": " << json_string(res.name)
+			<< ", \"median_ms\": " << json_number(res.median_ms)
+			<< ", \"p99_ms\": " << json_number(res.p99_ms)
+			<< ", \"min_ms\": " << json_number(res.min_ms)
+			<< ", \"mean_ms\": " << json_number(res.mean_ms)
+			<< ", \"items_per_run\": " << json_number(res.items_per_run)
+			<< ", \"item_unit\": " << json_string(res.item_unit)
+			<< ", \"items_per_second\": " << json_number(res.items_per_second())
+			<< ", \"result\": " << json_number(res.result) << "}";
+	}
+
+	os << "\n  ]\n}\n";
+}
@@ -0,0 +1,129 @@
+/*
+ * This file is licensed under the Mozilla Public License, v. 2.0.
+ * You can obtain a copy of the license at http://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#include "../Ch06/Timer.h"
+#include <string>
+#include <vector>
+#include <iosfwd>
+#include <utility>		// std::move
+
+// A small benchmark harness, used by the two executables in this directory
+// to catch performance regressions, eg when upgrading compilers:
+//
+//	PricingBenchmarks.cpp	Monte Carlo (sequential and parallel), Black-Scholes,
+//							implied volatility (Ch06); yield curve discount
+//							factors and bond valuation (Ch07).  Build with
+//							Ch06/BatchEquityPriceGenerator.cpp, BlackScholes.cpp,
+//							BrownianBridge.cpp, EquityPriceGenerator.cpp,
+//							MCCheckpoint.cpp, MCOptionValuation.cpp,
+//							MCShard.cpp, NormalSamplers.cpp, OptionInfo.cpp,
+//							Payoffs.cpp, RunningStats.cpp, ScenarioStore.cpp,
+//							SobolDirectionNumbers.cpp, SobolSequence.cpp, and
+//							ThreadPool.cpp, and
+//							Ch07/Bond.cpp, ChronoDate.cpp, DayCounts.cpp, and
+//							YieldCurve.cpp.
+//	LatticeBenchmarks.cpp	Binomial lattice (Ch09).  Build with
+//							Ch09/BinomialLatticePricer.cpp, OptionInfo.cpp,
+//							and Payoffs.cpp.
+//
+// The lattice is in a separate executable because Ch06 and Ch09 each have
+// their own OptionInfo and Payoff classes.  Both executables also need
+// Benchmark.cpp, and take the same command line options:
+//
+//	--warmup n		Untimed runs before timing each benchmark (default: 2)
+//	--reps n		Timed runs of each benchmark (default: 25)
+//	--filter text	Only run benchmarks whose name contains text
+//	--json file		Also write the results to file as JSON
+//
+// Build with optimization (eg, -O2 or /O2); the JSON records the compiler
+// and whether NDEBUG was defined, so that results can be compared.  Some of
+// the sources (eg, Ch06/OptionInfo.cpp and BlackScholes.cpp) use <format>, as
+// does the rest of the book's code, so a compiler with a C++20 standard
+// library that provides it is required: GCC 13 or later, Clang 17 or later
+// with libc++, or Visual Studio 2019 16.10 or later.
+
+struct BenchmarkOptions
+{
+	int warmup_runs{2};
+	int repetitions{25};
+	std::string filter{};
+	std::string json_file{};		// Empty: no JSON output
+
+	// Throws std::invalid_argument for an unknown or malformed option:
+	static BenchmarkOptions from_args(int argc, char* argv[]);
+};
+
+struct BenchmarkResult
+{
+	std::string name;
+	int repetitions;
+	double median_ms;
+	double p99_ms;					// Nearest-rank 99th percentile of the timed runs
+	double min_ms;
+	double mean_ms;
+	double items_per_run;			// Eg, paths or options per run (0: not applicable)
+	std::string item_unit;
+	double result;					// Value returned by the last run
+
+	double items_per_second() const;	// At the median time
+};
+
+class BenchmarkSuite
+{
+public:
+	BenchmarkSuite(std::string suite_name, BenchmarkOptions options);
+
+	// Times fn(), which returns the value it computed (eg, a price), so that
+	// the work cannot be optimized away, and so that a change in results
+	// shows up alongside a change in timings.  Each run does items_per_run
+	// items of work, in item_unit, for the throughput.  A line is printed to
+	// std::cout as each benchmark finishes:
+	template<typename F>
+	void run(const std::string& name, F&& fn, double items_per_run = 0.0,
+		const std::string& item_unit = "");
+
+	// Prints a summary, and writes the JSON file if requested:
+	void report(std::ostream& os) const;
+	void write_json(std::ostream& os) const;
+
+	const std::vector<BenchmarkResult>& results() const;
+
+private:
+	std::string suite_name_;
+	BenchmarkOptions options_;
+	std::vector<BenchmarkResult> results_;
+
+	bool selected_(const std::string& name) const;
+	void add_result_(const std::string& name, std::vector<double> times_ms,
+		double items_per_run, const std::string& item_unit, double result);
+};
+
+template<typename F>
+void BenchmarkSuite::run(const std::string& name, F&& fn, double items_per_run,
+	const std::string& item_unit)
+{
+	if (!selected_(name)) return;
+
+	double result = 0.0;
+	for (int i = 0; i < options_.warmup_runs; ++i)
+	{
+		result = fn();
+	}
+
+	std::vector<double> times_ms;
+	times_ms.reserve(options_.repetitions);
+	Timer tmr{};
+	for (int i = 0; i < options_.repetitions; ++i)
+	{
+		tmr.start();
+		result = fn();
+		tmr.stop();
+		times_ms.push_back(tmr.milliseconds());
+	}
+
+	add_result_(name, std::move(times_ms), items_per_run, item_unit, result);
+}
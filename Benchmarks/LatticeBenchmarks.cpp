@@ -0,0 +1,54 @@
+/*
+ * This file is licensed under the Mozilla Public License, v. 2.0.
+ * You can obtain a copy of the license at http://mozilla.org/MPL/2.0/.
+ */
+
+// Benchmarks of the Ch09 binomial lattice (see Benchmark.h).
+
+#include "Benchmark.h"
+#include "../Ch09/BinomialLatticePricer.h"
+
+#include <iostream>
+#include <memory>
+#include <string>
+#include <exception>
+
+namespace
+{
+	void lattice_benchmarks(BenchmarkSuite& suite)
+	{
+		for (int time_steps : {500, 2'000})
+		{
+			// A lattice with n time steps has (n + 1)(n + 2)/2 nodes:
+			const double num_nodes = 0.5 * (time_steps + 1.0) * (time_steps + 2.0);
+			const std::string steps = std::to_string(time_steps);
+
+			BinomialLatticePricer put{OptionInfo{std::make_unique<PutPayoff>(105.0), 1.0},
+				0.25, 0.05, time_steps, 0.02};
+
+			suite.run("lattice_euro_put_" + steps,
+				[&] { return put.calc_price(100.0, OptType::Euro); },
+				num_nodes, "nodes");
+
+			suite.run("lattice_american_put_" + steps,
+				[&] { return put.calc_price(100.0, OptType::American); },
+				num_nodes, "nodes");
+		}
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	try
+	{
+		BenchmarkSuite suite{"lattice", BenchmarkOptions::from_args(argc, argv)};
+		lattice_benchmarks(suite);
+		suite.report(std::cout);
+	}
+	catch (const std::exception& e)
+	{
+		std::cerr << e.what() << "\n"
+			<< "Usage: " << argv[0] << " [--warmup n] [--reps n] [--filter text] [--json file]\n";
+		return 1;
+	}
+}
@@ -0,0 +1,165 @@
+/*
+ * This file is licensed under the Mozilla Public License, v. 2.0.
+ * You can obtain a copy of the license at http://mozilla.org/MPL/2.0/.
+ */
+
+// Benchmarks of the Ch06 and Ch07 pricing code (see Benchmark.h).  The
+// Monte Carlo cases are those of perf_tests_euro_with_barrier_examples(.)
+// in Ch06, with 120 time steps and 50,000 scenarios.
+
+#include "Benchmark.h"
+#include "../Ch06/MCOptionValuation.h"
+#include "../Ch06/ThreadPool.h"
+#include "../Ch06/BlackScholes.h"
+#include "../Ch07/ChronoDate.h"
+#include "../Ch07/YieldCurve.h"
+#include "../Ch07/Bond.h"
+
+#include <iostream>
+#include <memory>
+#include <vector>
+#include <exception>
+
+namespace
+{
+	void monte_carlo_benchmarks(BenchmarkSuite& suite)
+	{
+		constexpr int time_steps = 120;
+		constexpr int num_scenarios = 50'000;
+		constexpr double spot = 100.0;
+		constexpr unsigned seed = 42;
+
+		// Down-and-out put, as in perf_tests_euro_with_barrier_examples(.):
+		MCOptionValuation val{OptionInfo{std::make_unique<PutPayoff>(105.0), 1.0},
+			time_steps, 0.25, 0.05, 0.08, BarrierType::down_and_out, 70.5};
+		ThreadPool pool{};
+
+		suite.run("mc_barrier_put_seq",
+			[&] { return val.calc_price(spot, num_scenarios, seed); },
+			num_scenarios, "paths");
+
+		suite.run("mc_barrier_put_async",
+			[&] { return val.calc_price_par(spot, num_scenarios, seed); },
+			num_scenarios, "paths");
+
+		suite.run("mc_barrier_put_pool",
+			[&] { return val.calc_price_with_error(spot, num_scenarios, seed, pool).price; },
+			num_scenarios, "paths");
+
+		val.set_path_backend(PathBackend::batch);
+		suite.run("mc_barrier_put_pool_batch",
+			[&] { return val.calc_price_with_error(spot, num_scenarios, seed, pool).price; },
+			num_scenarios, "paths");
+	}
+
+	void black_scholes_benchmarks(BenchmarkSuite& suite)
+	{
+		// Calls and puts struck from 50 to 150 (spot = 100), one year to expiration:
+		constexpr int num_options = 10'000;
+		std::vector<BlackScholes> options;
+		options.reserve(num_options);
+		for (int i = 0; i < num_options; ++i)
+		{
+			const double strike = 50.0 + 100.0 * i / num_options;
+			options.emplace_back(strike, 100.0, 1.0,
+				i % 2 == 0 ? PayoffType::Call : PayoffType::Put, 0.05, 0.02);
+		}
+
+		suite.run("black_scholes_price", [&]
+			{
+				double total = 0.0;
+				for (const auto& bsc : options) total += bsc(0.25);
+				return total;
+			}, num_options, "options");
+
+		// Implied vols recover the vol of 0.25 the market prices were computed from.
+		// Deep in or out of the money strikes are left out, as their prices are
+		// insensitive to the vol:
+		constexpr int num_implied = 1'000;
+		std::vector<BlackScholes> iv_options;
+		std::vector<double> mkt_prices;
+		for (int i = 0; i < num_implied; ++i)
+		{
+			const double strike = 80.0 + 40.0 * i / num_implied;
+			iv_options.emplace_back(strike, 100.0, 1.0,
+				i % 2 == 0 ? PayoffType::Call : PayoffType::Put, 0.05, 0.02);
+			mkt_prices.push_back(iv_options.back()(0.25));
+		}
+
+		suite.run("implied_volatility", [&]
+			{
+				double total = 0.0;
+				for (int i = 0; i < num_implied; ++i)
+				{
+					total += implied_volatility(iv_options[i], mkt_prices[i], 0.1, 0.5);
+				}
+				return total / num_implied;
+			}, num_implied, "options");
+	}
+
+	// The yield curve and 20 year bond of valuation_20_yr_bond() in Ch07:
+	void fixed_income_benchmarks(BenchmarkSuite& suite)
+	{
+		const ChronoDate settle_date{2023, 10, 10};
+		const std::vector<ChronoDate> unit_bond_maturity_dates
+		{
+			{2023, 10, 11}, {2024, 1, 10}, {2024, 4, 10}, {2024, 10, 10}, {2025, 10, 10}, {2026, 10, 12},
+			{2028, 10, 10}, {2030, 10, 10}, {2033, 10, 10}, {2038, 10, 11}, {2043, 10, 12}, {2053, 10, 10}
+		};
+		const std::vector<double> unit_bond_prices
+		{
+			0.999945, 0.994489, 0.98821, 0.973601, 0.939372, 0.901885,
+			0.827719, 0.759504, 0.670094, 0.547598, 0.448541, 0.300886
+		};
+		const LinearInterpYieldCurve yc{settle_date, unit_bond_maturity_dates, unit_bond_prices};
+
+		// Every day out to 30 years, less a day:
+		constexpr int num_dates = 30 * 365 - 1;
+		std::vector<ChronoDate> dates;
+		dates.reserve(num_dates);
+		ChronoDate date = settle_date;
+		for (int i = 0; i < num_dates; ++i)
+		{
+			dates.push_back(date.add_days(1));
+		}
+
+		suite.run("yield_curve_discount_factors", [&]
+			{
+				double total = 0.0;
+				for (const auto& d : dates) total += yc.discount_factor(settle_date, d);
+				return total;
+			}, num_dates, "discount factors");
+
+		Bond bond_20_yr{"20 yr bond", ChronoDate{2023, 5, 8}, ChronoDate{2023, 11, 7},
+			ChronoDate{2042, 11, 7}, ChronoDate{2043, 5, 7}, 2, 0.062, 1000.0};
+
+		constexpr int num_valuations = 1'000;
+		suite.run("bond_valuation", [&]
+			{
+				double total = 0.0;
+				for (int i = 0; i < num_valuations; ++i)
+				{
+					total += bond_20_yr.discounted_value(settle_date, yc);
+				}
+				return total / num_valuations;
+			}, num_valuations, "bonds");
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	try
+	{
+		BenchmarkSuite suite{"pricing", BenchmarkOptions::from_args(argc, argv)};
+		monte_carlo_benchmarks(suite);
+		black_scholes_benchmarks(suite);
+		fixed_income_benchmarks(suite);
+		suite.report(std::cout);
+	}
+	catch (const std::exception& e)
+	{
+		std::cerr << e.what() << "\n"
+			<< "Usage: " << argv[0] << " [--warmup n] [--reps n] [--filter text] [--json file]\n";
+		return 1;
+	}
+}
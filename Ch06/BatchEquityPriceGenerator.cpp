@@ -0,0 +1,229 @@
+/*
+ * This file is licensed under the Mozilla Public License, v. 2.0.
+ * You can obtain a copy of the license at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "BatchEquityPriceGenerator.h"
+
+#include <cmath>
+#include <numbers>
+#include <bit>			// std::bit_cast
+#include <array>
+#include <cstdint>
+#include <algorithm>	// std::min, std::fill_n
+#include <type_traits>
+#include <stdexcept>
+
+namespace
+{
+	// exp(x) without branches or calls, so that a loop over it can be vectorized.
+	// x = n * ln(2) + r with |r| <= ln(2)/2, so exp(x) = 2^n * exp(r); exp(r) is
+	// a degree 13 Taylor polynomial (relative error < 1e-16), and 2^n is built
+	// directly in the exponent bits of a double.
+	inline double fast_exp(double x)
+	{
+		using namespace std::numbers;
+		constexpr double ln2_hi = 0.693147180369123816490;			// ln(2) split in two,
+		constexpr double ln2_lo = 1.90821492927058770002e-10;		// so that n * ln2_hi is exact
+		constexpr double two_to_52 = 4503599627370496.0;
+
+		x = x < -708.0 ? -708.0 : x;		// Rather than std::clamp, which returns
+		x = x > 708.0 ? 708.0 : x;			// a reference and blocks if-conversion
+		const double n = std::nearbyint(x * log2e);
+		const double r = (x - n * ln2_hi) - n * ln2_lo;
+
+		// Adding 2^52 leaves the (biased) exponent n + 1023 in the low mantissa bits:
+		const auto biased_n = std::bit_cast<std::uint64_t>(n + (1023.0 + two_to_52));
+
+		double p = 1.0 / 6227020800.0;					// 1/13!
+		p = p * r + 1.0 / 479001600.0;
+		p = p * r + 1.0 / 39916800.0;
+		p = p * r + 1.0 / 3628800.0;
+		p = p * r + 1.0 / 362880.0;
+		p = p * r + 1.0 / 40320.0;
+		p = p * r + 1.0 / 5040.0;
+		p = p * r + 1.0 / 720.0;
+		p = p * r + 1.0 / 120.0;
+		p = p * r + 1.0 / 24.0;
+		p = p * r + 1.0 / 6.0;
+		p = p * r + 0.5;
+		p = p * r + 1.0;
+		p = p * r + 1.0;
+
+		const double two_to_n = std::bit_cast<double>(biased_n << 52);
+		return p * two_to_n;
+	}
+
+	// log(u) for normal, positive u, in the same branch-free style: u = m * 2^e
+	// with m in [sqrt(2)/2, sqrt(2)], and log(m) = 2 atanh(s), s = (m - 1)/(m + 1),
+	// from its odd series in s (|s| < 0.172, so 11 terms are enough).
+	inline double fast_log(double u)
+	{
+		using namespace std::numbers;
+		constexpr double two_to_52 = 4503599627370496.0;
+		constexpr std::uint64_t mantissa_mask = 0x000fffffffffffff;
+		constexpr std::uint64_t exponent_zero = 0x3ff0000000000000;		// bits of 1.0
+
+		const auto bits = std::bit_cast<std::uint64_t>(u);
+		double m = std::bit_cast<double>((bits & mantissa_mask) | exponent_zero);	// [1, 2)
+		double e = std::bit_cast<double>((bits >> 52) | 0x4330000000000000)			// 2^52 + biased e
+			- (two_to_52 + 1023.0);
+
+		const double above = m > sqrt2 ? 1.0 : 0.0;		// Selects are written as arithmetic
+		m *= 1.0 - 0.5 * above;							// on 0/1, which vectorizes without
+		e += above;										// needing -fno-trapping-math
+
+		const double s = (m - 1.0) / (m + 1.0);
+		const double s2 = s * s;
+		double p = 1.0 / 21.0;
+		p = p * s2 + 1.0 / 19.0;
+		p = p * s2 + 1.0 / 17.0;
+		p = p * s2 + 1.0 / 15.0;
+		p = p * s2 + 1.0 / 13.0;
+		p = p * s2 + 1.0 / 11.0;
+		p = p * s2 + 1.0 / 9.0;
+		p = p * s2 + 1.0 / 7.0;
+		p = p * s2 + 1.0 / 5.0;
+		p = p * s2 + 1.0 / 3.0;
+		p = p * s2 + 1.0;
+
+		return e * ln2 + 2.0 * s * p;
+	}
+
+	// cos and sin of 2 pi t for t in [-1/2, 1/2], branch-free: the angle is reduced
+	// by the nearest quarter turn q to |r| <= pi/4, where Taylor polynomials of
+	// degree 16/17 are accurate to < 1e-16, and the result is rotated back by q.
+	inline void fast_sincos_2pi(double t, double& cos_out, double& sin_out)
+	{
+		using namespace std::numbers;
+		const double q = std::nearbyint(4.0 * t);
+		const double r = (2.0 * pi) * (t - 0.25 * q);
+		const double r2 = r * r;
+
+		double c = 1.0 / 20922789888000.0;			// 1/16!
+		c = c * r2 - 1.0 / 87178291200.0;
+		c = c * r2 + 1.0 / 479001600.0;
+		c = c * r2 - 1.0 / 3628800.0;
+		c = c * r2 + 1.0 / 40320.0;
+		c = c * r2 - 1.0 / 720.0;
+		c = c * r2 + 1.0 / 24.0;
+		c = c * r2 - 0.5;
+		c = c * r2 + 1.0;
+
+		double s = 1.0 / 355687428096000.0;			// 1/17!
+		s = s * r2 - 1.0 / 1307674368000.0;
+		s = s * r2 + 1.0 / 6227020800.0;
+		s = s * r2 - 1.0 / 39916800.0;
+		s = s * r2 + 1.0 / 362880.0;
+		s = s * r2 - 1.0 / 5040.0;
+		s = s * r2 + 1.0 / 120.0;
+		s = s * r2 - 1.0 / 6.0;
+		s = s * r2 + 1.0;
+		s *= r;
+
+		// Rotate (cos r, sin r) by q quarter turns (one of the two
+		// terms in each blend is exactly zero, so no accuracy is lost):
+		const int quadrant = static_cast<int>(q) & 3;
+		const double odd = static_cast<double>(quadrant & 1);
+		const double sign = 1.0 - static_cast<double>(quadrant & 2);	// -1 for quadrants 2, 3
+		cos_out = sign * ((1.0 - odd) * c - odd * s);
+		sin_out = sign * ((1.0 - odd) * s + odd * c);
+	}
+
+	// Uniforms in the open interval (0, 1), from 53 random bits each.  Philox4x32
+	// generates its results a run of blocks at a time (Philox4x32::fill(.)); other
+	// engines are called once per result:
+	template<typename URBG>
+	void fill_uniforms(URBG& urbg, std::span<double> u)
+	{
+		std::array<std::uint64_t, 64> bits;
+		for (std::size_t first = 0; first < u.size(); first += bits.size())
+		{
+			const std::size_t n = std::min(bits.size(), u.size() - first);
+			if constexpr (std::is_same_v<URBG, Philox4x32>)
+			{
+				urbg.fill(std::span{bits}.first(n));
+			}
+			else
+			{
+				for (std::size_t j = 0; j < n; ++j) bits[j] = urbg();
+			}
+
+			for (std::size_t j = 0; j < n; ++j)
+			{
+				u[first + j] = (static_cast<double>(bits[j] >> 11) + 0.5) * 0x1.0p-53;
+			}
+		}
+	}
+
+	// Replaces the uniforms in one step of the lanes with standard normals, by
+	// Box-Muller on pairs of lanes (k, k + lanes/2):
+	void normals_from_uniforms(double* z)
+	{
+		constexpr std::size_t half = BatchEquityPriceGenerator::lanes / 2;
+
+		for (std::size_t k = 0; k < half; ++k)
+		{
+			const double radius = std::sqrt(-2.0 * fast_log(z[k]));
+			double cos_angle, sin_angle;
+			fast_sincos_2pi(z[k + half] - 0.5, cos_angle, sin_angle);	// Uniform angle in (-pi, pi)
+			z[k] = radius * cos_angle;
+			z[k + half] = radius * sin_angle;
+		}
+	}
+}
+
+BatchEquityPriceGenerator::BatchEquityPriceGenerator(double spot, int num_time_steps,
+	double time_to_expiration, double volatility, double rf_rate, double div_rate) :
+	spot_{spot}, num_time_steps_{num_time_steps}
+{
+	const double dt = time_to_expiration / num_time_steps;
+	drift_ = (rf_rate - div_rate - (volatility * volatility) / 2.0) * dt;
+	vol_sqrt_dt_ = volatility * std::sqrt(dt);
+}
+
+void BatchEquityPriceGenerator::operator()(int seed, std::span<double> paths) const
+{
+	std::mt19937_64 mt(seed);
+	(*this)(mt, paths);
+}
+
+void BatchEquityPriceGenerator::operator()(std::mt19937_64& mt, std::span<double> paths) const
+{
+	generate_paths_(mt, paths);
+}
+
+void BatchEquityPriceGenerator::operator()(Philox4x32& rng, std::span<double> paths) const
+{
+	generate_paths_(rng, paths);
+}
+
+template<typename URBG>
+void BatchEquityPriceGenerator::generate_paths_(URBG& urbg, std::span<double> paths) const
+{
+	if (paths.size() != (static_cast<std::size_t>(num_time_steps_) + 1) * lanes)
+	{
+		throw std::invalid_argument{
+			"BatchEquityPriceGenerator: paths must hold (num_time_steps + 1) * lanes prices"};
+	}
+
+	// Each pass runs over all the steps of the block, in place in `paths`, so
+	// that none of them waits on the engine: the uniforms, then the normals,
+	// then the price ratios over each step, and last their running products.
+	const std::span<double> steps = paths.subspan(lanes);
+	fill_uniforms(urbg, steps);
+	for (std::size_t i = 0; i < steps.size(); i += lanes)
+	{
+		normals_from_uniforms(steps.data() + i);
+	}
+	for (double& x : steps)
+	{
+		x = fast_exp(drift_ + vol_sqrt_dt_ * x);
+	}
+
+	std::fill_n(paths.begin(), lanes, spot_);
+	for (std::size_t i = lanes; i < paths.size(); ++i)
+	{
+		paths[i] *= paths[i - lanes];
+	}
+}
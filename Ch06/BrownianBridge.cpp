@@ -0,0 +1,78 @@
+/*
+ * This file is licensed under the Mozilla Public License, v. 2.0.
+ * You can obtain a copy of the license at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "BrownianBridge.h"
+
+#include <cmath>
+#include <stdexcept>
+
+// The construction order follows Jaeckel, "Monte Carlo Methods in Finance",
+// ch 10, on the (unit spaced) times t_i = i + 1, i = 0, ..., num_steps - 1:
+BrownianBridge::BrownianBridge(std::size_t num_steps) :
+	bridge_index_(num_steps), left_index_(num_steps), right_index_(num_steps),
+	left_weight_(num_steps), right_weight_(num_steps), std_dev_(num_steps)
+{
+	if (num_steps == 0)
+	{
+		throw std::invalid_argument{"BrownianBridge: num_steps must be positive"};
+	}
+
+	auto t = [](std::size_t i) {return static_cast<double>(i + 1);};
+
+	std::vector<bool> filled(num_steps, false);
+	filled[num_steps - 1] = true;
+	bridge_index_[0] = num_steps - 1;
+	std_dev_[0] = std::sqrt(t(num_steps - 1));
+
+	for (std::size_t i = 1, j = 0; i < num_steps; ++i)
+	{
+		while (filled[j]) ++j;			// Start of the next gap...
+		std::size_t k = j;
+		while (!filled[k]) ++k;			// ...and the filled point that ends it
+		const std::size_t l = j + ((k - 1 - j) >> 1);	// Midpoint of the gap
+
+		filled[l] = true;
+		bridge_index_[i] = l;
+		left_index_[i] = j;
+		right_index_[i] = k;
+
+		const double t_left = (j == 0) ? 0.0 : t(j - 1);
+		left_weight_[i] = (t(k) - t(l)) / (t(k) - t_left);
+		right_weight_[i] = (t(l) - t_left) / (t(k) - t_left);
+		std_dev_[i] = std::sqrt((t(l) - t_left) * (t(k) - t(l)) / (t(k) - t_left));
+
+		j = k + 1;
+		if (j >= num_steps) j = 0;		// Wrap around to the first gap
+	}
+}
+
+std::size_t BrownianBridge::num_steps() const
+{
+	return bridge_index_.size();
+}
+
+void BrownianBridge::transform(std::span<const double> z, std::span<double> increments) const
+{
+	const std::size_t n = num_steps();
+	if (z.size() != n || increments.size() != n)
+	{
+		throw std::invalid_argument{"BrownianBridge: spans must hold num_steps() values"};
+	}
+
+	// Build W(t_0), ..., W(t_(n-1)) in place, then difference it:
+	auto w = increments;
+	w[n - 1] = std_dev_[0] * z[0];
+	for (std::size_t i = 1; i < n; ++i)
+	{
+		const std::size_t j = left_index_[i], k = right_index_[i], l = bridge_index_[i];
+		const double w_left = (j == 0) ? 0.0 : w[j - 1];
+		w[l] = left_weight_[i] * w_left + right_weight_[i] * w[k] + std_dev_[i] * z[i];
+	}
+
+	for (std::size_t i = n - 1; i > 0; --i)
+	{
+		w[i] -= w[i - 1];
+	}
+}
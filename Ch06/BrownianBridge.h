@@ -0,0 +1,36 @@
+/*
+ * This file is licensed under the Mozilla Public License, v. 2.0.
+ * You can obtain a copy of the license at http://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#include <vector>
+#include <span>
+#include <cstddef>
+
+// Brownian-bridge construction of a Brownian path on num_steps equal time
+// steps.  The first normal fixes the end point W(T), the second the midpoint,
+// then the quarter points, and so on.  Each path is still a standard Brownian
+// motion, but most of its variance is carried by the first few normals, which
+// is where a Sobol sequence is most uniform -- so quasi-Monte Carlo estimates
+// converge much faster than when the path is built step by step.
+class BrownianBridge
+{
+public:
+	explicit BrownianBridge(std::size_t num_steps);
+
+	std::size_t num_steps() const;
+
+	// Maps independent standard normals z (in order of importance) to the
+	// increments of the bridged path, W(t_i) - W(t_(i-1)), scaled to unit
+	// variance, so that they can replace step-by-step normal draws.  Both spans
+	// hold num_steps() values, and may not overlap:
+	void transform(std::span<const double> z, std::span<double> increments) const;
+
+private:
+	// The point filled at stage i is bridge_index_[i], conditioned on the points
+	// at left_index_[i] - 1 (or W(0) = 0 if left_index_[i] == 0) and right_index_[i]:
+	std::vector<std::size_t> bridge_index_, left_index_, right_index_;
+	std::vector<double> left_weight_, right_weight_, std_dev_;
+};
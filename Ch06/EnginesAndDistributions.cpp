@@ -4,6 +4,9 @@
  */
 
 #include "ExampleDeclarations.h"
+#include "NormalSamplers.h"
+#include "Philox.h"
+#include "Timer.h"
 
 #include <random>
 #include <algorithm>
@@ -27,6 +30,7 @@ void engines_and_distributions()
 	other_distributions();
 	shuffle_algo_example();
 	max_drawdown_sim();
+	normal_sampler_benchmark();
 }
 
 
@@ -390,4 +394,45 @@ void max_drawdown_sim()
 	cout << "Worst possible maximum drawdown at 99% confidence = ";
 	print_dec_form(max_dd_conf_lev);
 	print_this("\n\n");
-}
\ No newline at end of file
+}
+
+void normal_sampler_benchmark()
+{
+	using std::cout, std::format;
+	cout << "\n*** normal_sampler_benchmark() ***\n";
+
+	// Time to fill a vector with standard normals, for each sampler and engine,
+	// with the sample mean and variance as a sanity check:
+	std::vector<double> norms(10'000'000);
+
+	auto run = [&norms](const char* label, auto fill)
+	{
+		Timer tmr{};
+		tmr.start();
+		fill(norms);
+		tmr.stop();
+
+		double sum = 0.0, sum_sq = 0.0;
+		for (double x : norms)
+		{
+			sum += x;
+			sum_sq += x * x;
+		}
+		const double n = static_cast<double>(norms.size());
+		const double mean = sum / n;
+		cout << format("{:<40} {:6.2f} ns/normal, mean = {:8.5f}, variance = {:.5f}\n", label,
+			1.0e6 * tmr.milliseconds() / n, mean, sum_sq / n - mean * mean);
+	};
+
+	std::mt19937_64 mt{40};
+	Philox4x32 rng{40, 0};
+	std::normal_distribution<> nd;
+	ZigguratNormal zn;
+
+	run("std::normal_distribution, mt19937_64", [&](std::vector<double>& v) {for (double& x : v) x = nd(mt);});
+	run("std::normal_distribution, Philox4x32", [&](std::vector<double>& v) {for (double& x : v) x = nd(rng);});
+	run("ZigguratNormal, mt19937_64", [&](std::vector<double>& v) {zn.fill(mt, v);});
+	run("ZigguratNormal, Philox4x32", [&](std::vector<double>& v) {zn.fill(rng, v);});
+
+	cout << "\n";
+}
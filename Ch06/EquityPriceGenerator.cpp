@@ -4,45 +4,144 @@
  */
 
 #include "EquityPriceGenerator.h"
+#include "NormalSamplers.h"
 #include <cmath>
 #include <random>
 #include <algorithm>
+#include <stdexcept>
+#include <limits>
+
+namespace
+{
+	// Barrier levels that are never reached:
+	constexpr double no_lower_barrier = -std::numeric_limits<double>::infinity();
+	constexpr double no_upper_barrier = std::numeric_limits<double>::infinity();
+}
 
 EquityPriceGenerator::EquityPriceGenerator(double spot, int num_time_steps,
 	double time_to_expiration, double volatility, double rf_rate, double div_rate) :
 	spot_{spot}, num_time_steps_{num_time_steps}, time_to_expiration_{time_to_expiration},
 	volatility_{volatility}, rf_rate_{rf_rate}, div_rate_{div_rate},
-	dt_{time_to_expiration / num_time_steps} {}
+	dt_{time_to_expiration / num_time_steps},
+	drift_{(rf_rate - div_rate - (volatility * volatility) / 2.0) * dt_},
+	vol_sqrt_dt_{volatility * std::sqrt(dt_)},
+	terminal_drift_{drift_ * num_time_steps},
+	terminal_vol_{volatility * std::sqrt(time_to_expiration)} {}
 
 std::vector<double> EquityPriceGenerator::operator()(int seed) const
 {
-	std::vector<double> v;
-	v.reserve(num_time_steps_ + 1);
+	std::vector<double> v(num_time_steps_ + 1);
+	(*this)(seed, v);
+	return v;
+}
 
+void EquityPriceGenerator::operator()(int seed, std::span<double> path) const
+{
 	std::mt19937_64 mt(seed);
-	std::normal_distribution<> nd;
+	(*this)(mt, path);
+}
 
-	auto new_price = [this](double previous_equity_price, double norm)
+void EquityPriceGenerator::operator()(std::mt19937_64& mt, std::span<double> path) const
+{
+	generate_path_(mt, path, no_lower_barrier, no_upper_barrier);
+}
+
+void EquityPriceGenerator::operator()(Philox4x32& rng, std::span<double> path) const
+{
+	generate_path_(rng, path, no_lower_barrier, no_upper_barrier);
+}
+
+int EquityPriceGenerator::operator()(Philox4x32& rng, std::span<double> path,
+	double lower_barrier, double upper_barrier) const
+{
+	return generate_path_(rng, path, lower_barrier, upper_barrier);
+}
+
+template<typename URBG>
+int EquityPriceGenerator::generate_path_(URBG& urbg, std::span<double> path,
+	double lower_barrier, double upper_barrier) const
+{
+	if (path.size() != static_cast<std::size_t>(num_time_steps_) + 1)
 	{
-		double price{0.0};
+		throw std::invalid_argument{"EquityPriceGenerator: path must hold num_time_steps + 1 prices"};
+	}
 
-		double exp_arg_01 = (rf_rate_ - div_rate_ - 
-			((volatility_ * volatility_) / 2.0)) * dt_;
-		double exp_arg_02 = volatility_ * norm * sqrt(dt_);
-		price = previous_equity_price * std::exp(exp_arg_01 + exp_arg_02);
+	ZigguratNormal zn;
 
-		return price;
+	auto new_price = [this](double previous_equity_price, double norm)
+	{
+		return previous_equity_price * std::exp(drift_ + vol_sqrt_dt_ * norm);
 	};
 
-	v.push_back(spot_);				// put initial equity price into the 1st position in the vector
+	path[0] = spot_;				// put initial equity price into the 1st position in the path
 	double equity_price = spot_;
 
 	for (int i = 1; i <= num_time_steps_; ++i)	// i <= num_time_steps_ since we need a price 
 												// at the end of the final time step.
 	{											
-		equity_price = new_price(equity_price, nd(mt));	// norm = nd(mt)
-		v.push_back(equity_price);
+		equity_price = new_price(equity_price, zn(urbg));	// norm = zn(urbg)
+		path[i] = equity_price;
+
+		// The barrier test is fused into the stepping, so that a knocked-out
+		// path is abandoned at once:
+		if (equity_price <= lower_barrier || equity_price >= upper_barrier) return i;
 	}
 
-	return v;
+	return num_time_steps_;
+}
+
+double EquityPriceGenerator::terminal_price(int seed) const
+{
+	std::mt19937_64 mt(seed);
+	return terminal_price(mt);
+}
+
+double EquityPriceGenerator::terminal_price(std::mt19937_64& mt) const
+{
+	return generate_terminal_price_(mt);
+}
+
+double EquityPriceGenerator::terminal_price(Philox4x32& rng) const
+{
+	return generate_terminal_price_(rng);
+}
+
+template<typename URBG>
+double EquityPriceGenerator::generate_terminal_price_(URBG& urbg) const
+{
+	ZigguratNormal zn;
+	return terminal_price_from_normal(zn(urbg));
+}
+
+void EquityPriceGenerator::path_from_normals(std::span<const double> normals,
+	std::span<double> path) const
+{
+	path_from_normals(normals, path, no_lower_barrier, no_upper_barrier);
+}
+
+int EquityPriceGenerator::path_from_normals(std::span<const double> normals,
+	std::span<double> path, double lower_barrier, double upper_barrier) const
+{
+	if (normals.size() != static_cast<std::size_t>(num_time_steps_)
+		|| path.size() != normals.size() + 1)
+	{
+		throw std::invalid_argument{"EquityPriceGenerator: need num_time_steps normals "
+			"and num_time_steps + 1 prices"};
+	}
+
+	path[0] = spot_;
+	double equity_price = spot_;
+	for (int i = 1; i <= num_time_steps_; ++i)
+	{
+		equity_price *= std::exp(drift_ + vol_sqrt_dt_ * normals[i - 1]);
+		path[i] = equity_price;
+		if (equity_price <= lower_barrier || equity_price >= upper_barrier) return i;
+	}
+
+	return num_time_steps_;
+}
+
+double EquityPriceGenerator::terminal_price_from_normal(double norm) const
+{
+	return spot_ * std::exp(terminal_drift_ + terminal_vol_ * norm);
 }
@@ -5,7 +5,9 @@
 
 #pragma once
 
+#include "Philox.h"
 #include <vector>
+#include <span>
 #include <random>
 
 class EquityPriceGenerator
@@ -16,6 +18,35 @@ public:
 
 	std::vector<double> operator()(int seed) const;
 
+	// Allocation-free versions: the scenario is written into `path`, which must
+	// hold num_time_steps + 1 prices.  The second form draws from a caller-owned
+	// engine, so that one engine (eg, per thread) can be reused across scenarios.
+	void operator()(int seed, std::span<double> path) const;
+	void operator()(std::mt19937_64& mt, std::span<double> path) const;
+	void operator()(Philox4x32& rng, std::span<double> path) const;
+
+	// Samples the price at expiration directly from its lognormal
+	// distribution with a single draw, skipping the intermediate steps:
+	double terminal_price(int seed) const;
+	double terminal_price(std::mt19937_64& mt) const;
+	double terminal_price(Philox4x32& rng) const;
+
+	// The same, from normal variates supplied by the caller (eg, quasi-random
+	// normals, or increments from a BrownianBridge): `normals` holds one standard
+	// normal per time step, and terminal_price_from_normal(.) takes the single
+	// normal that drives S(T):
+	void path_from_normals(std::span<const double> normals, std::span<double> path) const;
+	double terminal_price_from_normal(double norm) const;
+
+	// Knock-out versions: stepping stops at the first price at or below
+	// lower_barrier, or at or above upper_barrier, leaving the rest of the path
+	// unset.  The return value is the number of time steps generated, which is
+	// less than num_time_steps only if the path knocked out before expiration:
+	int operator()(Philox4x32& rng, std::span<double> path,
+		double lower_barrier, double upper_barrier) const;
+	int path_from_normals(std::span<const double> normals, std::span<double> path,
+		double lower_barrier, double upper_barrier) const;
+
 private:	
 	double spot_;
 	int num_time_steps_;
@@ -24,4 +55,18 @@ private:
 	double rf_rate_;		// Continuous risk-free rate
 	double div_rate_;		// Continuous dividend rate
 	double dt_;				// dt_ = "delta t"
+
+	// Per-step constants, computed once in the constructor:
+	double drift_;			// (rf_rate_ - div_rate_ - volatility_^2/2) * dt_
+	double vol_sqrt_dt_;	// volatility_ * sqrt(dt_)
+	double terminal_drift_;	// drift_ * num_time_steps_
+	double terminal_vol_;	// volatility_ * sqrt(time_to_expiration_)
+
+	// Common implementations for each engine type (defined in the .cpp file):
+	template<typename URBG>
+	int generate_path_(URBG& urbg, std::span<double> path, double lower_barrier,
+		double upper_barrier) const;
+
+	template<typename URBG>
+	double generate_terminal_price_(URBG& urbg) const;
 };
\ No newline at end of file
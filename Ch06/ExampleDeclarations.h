@@ -21,6 +21,7 @@ void mersenne_twister_and_normal_dist();
 void other_distributions();
 void shuffle_algo_example();
 void max_drawdown_sim();
+void normal_sampler_benchmark();		// Ziggurat vs std::normal_distribution
 
 // Monte Carlo Simulation for Option Valuation
 // (non-parallel version 1st, then followed by parallel STL algos,
@@ -29,6 +30,18 @@ void mc_option_examples();				// Top calling function
 										// See MCOptionExamples.cpp
 void euro_no_barrier_examples();		
 void euro_with_barrier_examples();
+void euro_qmc_examples();				// Sobol vs pseudo-random sampling
+void euro_variance_reduction_examples();	// Antithetic paths and control variate
+void euro_greeks_examples();				// Price and Greeks from one set of paths
+void euro_portfolio_examples();				// A book of options on shared paths
+void euro_adaptive_examples();				// Run to a target std error or time budget
+void american_lsmc_examples();				// Longstaff-Schwartz early exercise
+void multi_asset_examples();				// Basket, best-of and worst-of options
+void path_model_examples();					// Heston, SABR and local vol paths
+void barrier_mlmc_examples();				// Multilevel Monte Carlo, daily barrier
+void path_functional_examples();			// Asian, lookback and range accrual payoffs
+void risk_ladder_examples();				// Spot/vol grid with common random numbers
+void scenario_store_examples();			// Pricing from memory-mapped stored paths
 
 // Parallel STL Algorithms
 void parallel_stl_algorithms();			// Top calling function
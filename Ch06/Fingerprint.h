@@ -0,0 +1,73 @@
+/*
+ * This file is licensed under the Mozilla Public License, v. 2.0.
+ * You can obtain a copy of the license at http://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#include "OptionInfo.h"
+
+#include <array>
+#include <bit>			// std::bit_cast
+#include <cmath>
+#include <cstdint>
+#include <type_traits>
+
+// A 64-bit FNV-1a hash of the parameters and settings of a valuation.  It is
+// kept in shard and checkpoint files (MCShard.h, MCCheckpoint.h), so that the
+// statistics of one valuation are never merged into those of another that
+// happens to have the same seed and number of paths.
+class Fingerprint
+{
+public:
+	template<typename T>
+		requires std::is_arithmetic_v<T> || std::is_enum_v<T>
+	Fingerprint& add(T value);
+
+	// A payoff is identified by its path dependence and its values at a fixed
+	// set of prices around spot, as its parameters are not visible here:
+	Fingerprint& add(const OptionInfo& opt, double spot);
+
+	std::uint64_t value() const { return hash_; }
+
+private:
+	std::uint64_t hash_{14695981039346656037ull};
+};
+
+template<typename T>
+	requires std::is_arithmetic_v<T> || std::is_enum_v<T>
+Fingerprint& Fingerprint::add(T value)
+{
+	std::uint64_t bits = 0;
+	if constexpr (std::is_floating_point_v<T>)
+		bits = std::bit_cast<std::uint64_t>(static_cast<double>(value));
+	else if constexpr (std::is_enum_v<T>)
+		bits = static_cast<std::uint64_t>(static_cast<std::underlying_type_t<T>>(value));
+	else
+		bits = static_cast<std::uint64_t>(value);
+
+	for (int byte = 0; byte < 8; ++byte)
+	{
+		hash_ ^= (bits >> (8 * byte)) & 0xff;
+		hash_ *= 1099511628211ull;
+	}
+	return *this;
+}
+
+inline Fingerprint& Fingerprint::add(const OptionInfo& opt, double spot)
+{
+	// Prices from spot/20 to 20 spot, about 0.6% apart:
+	constexpr std::size_t num_prices = 1024;
+	std::array<double, num_prices> prices, payoffs;
+	for (std::size_t k = 0; k < num_prices; ++k)
+	{
+		const double x = 2.0 * static_cast<double>(k) / (num_prices - 1) - 1.0;
+		prices[k] = spot * std::exp(3.0 * x);
+	}
+	opt.option_payoffs(prices, payoffs);
+
+	add(opt.path_dependence());
+	add(opt.time_to_expiration());
+	for (double payoff : payoffs) add(payoff);
+	return *this;
+}
@@ -0,0 +1,235 @@
+/*
+ * This file is licensed under the Mozilla Public License, v. 2.0.
+ * You can obtain a copy of the license at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "LSMCValuation.h"
+#include "EquityPriceGenerator.h"
+#include "Philox.h"
+#include "RunningStats.h"
+#include "Timer.h"
+
+#include <Eigen/Dense>
+#include <utility>		// std::move
+#include <cmath>
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+LSMCValuation::LSMCValuation(OptionInfo&& opt, int time_steps, double vol, double int_rate,
+	double div_rate, BarrierType barrier_type, double barrier_value,
+	std::vector<int> exercise_steps, int basis_degree) :
+	opt_{std::move(opt)}, time_steps_{time_steps}, vol_{vol}, int_rate_{int_rate},
+	div_rate_{div_rate}, barrier_type_{barrier_type}, barrier_value_{barrier_value},
+	exercise_steps_{std::move(exercise_steps)}, american_{exercise_steps_.empty()},
+	basis_degree_{basis_degree}
+{
+	if (time_steps_ < 1 || basis_degree_ < 1)
+	{
+		throw std::invalid_argument{"LSMCValuation: time_steps and basis_degree must be positive"};
+	}
+
+	if (american_)
+	{
+		for (int step = 1; step < time_steps_; ++step)
+		{
+			exercise_steps_.push_back(step);
+		}
+	}
+
+	std::ranges::sort(exercise_steps_);
+	auto [last, end] = std::ranges::unique(exercise_steps_);
+	exercise_steps_.erase(last, end);
+	std::erase_if(exercise_steps_, [this](int step) {return step >= time_steps_;});	// Expiration
+
+	if (!exercise_steps_.empty() && exercise_steps_.front() < 1)
+	{
+		throw std::invalid_argument{"LSMCValuation: exercise steps must be in 1, ..., time_steps"};
+	}
+}
+
+MCResult LSMCValuation::calc_price(double spot, int num_scenarios, unsigned unif_start_seed)
+{
+	return run_(spot, num_scenarios, unif_start_seed, nullptr);
+}
+
+MCResult LSMCValuation::calc_price(double spot, int num_scenarios, unsigned unif_start_seed,
+	ThreadPool& pool)
+{
+	return run_(spot, num_scenarios, unif_start_seed, &pool);
+}
+
+MCResult LSMCValuation::run_(double spot, int num_scenarios, std::uint64_t seed,
+	ThreadPool* pool) const
+{
+	using Eigen::MatrixXd, Eigen::VectorXd;
+
+	Timer tmr{};
+	tmr.start();
+
+	const double time_to_exp = opt_.time_to_expiration();
+	bool barrier_hit =
+		(barrier_type_ == BarrierType::up_and_out && spot >= barrier_value_) ||
+		(barrier_type_ == BarrierType::down_and_out && spot <= barrier_value_);
+
+	if (barrier_hit) return MCResult{};
+	if (time_to_exp <= 0.0) return MCResult{opt_.option_payoff(spot)};
+
+	const std::size_t num_paths = static_cast<std::size_t>(num_scenarios);
+	const std::size_t num_blocks = (num_paths + paths_per_block - 1) / paths_per_block;
+	const std::size_t num_dates = exercise_steps_.size();
+	const double dt = time_to_exp / time_steps_;
+
+	// Runs fn(block) for every block, on the pool if there is one:
+	auto for_each_block = [pool, num_blocks](auto fn)
+	{
+		if (pool)
+		{
+			pool->parallel_for(num_blocks, fn);
+		}
+		else
+		{
+			for (std::size_t block = 0; block < num_blocks; ++block) fn(block);
+		}
+	};
+	auto block_range = [num_paths](std::size_t block)
+	{
+		const std::size_t first = block * paths_per_block;
+		return std::pair{first, std::min(first + paths_per_block, num_paths)};
+	};
+
+	// (1) Simulate, keeping the prices at the exercise dates (date-major, so each
+	// regression reads contiguous memory), the knock-out step of each path
+	// (time_steps_ + 1 if none), and the present value of its cash flow at expiration:
+	std::vector<double> date_prices(num_dates * num_paths);
+	std::vector<int> knock_step(num_paths);
+	std::vector<double> cash_flow_pv(num_paths);
+
+	constexpr double inf = std::numeric_limits<double>::infinity();
+	const double lower_barrier = barrier_type_ == BarrierType::down_and_out ? barrier_value_ : -inf;
+	const double upper_barrier = barrier_type_ == BarrierType::up_and_out ? barrier_value_ : inf;
+	const double disc_exp = std::exp(-int_rate_ * time_to_exp);
+
+	for_each_block([&](std::size_t block)
+		{
+			EquityPriceGenerator epg{spot, time_steps_, time_to_exp, vol_, int_rate_, div_rate_};
+			std::vector<double> scenario(time_steps_ + 1);
+			auto [first, last] = block_range(block);
+			for (std::size_t i = first; i < last; ++i)
+			{
+				Philox4x32 rng{seed, i};
+				const int steps = epg(rng, scenario, lower_barrier, upper_barrier);
+				const bool knocked = scenario[steps] <= lower_barrier || scenario[steps] >= upper_barrier;
+				knock_step[i] = knocked ? steps : time_steps_ + 1;
+
+				for (std::size_t d = 0; d < num_dates; ++d)
+				{
+					const int step = exercise_steps_[d];
+					date_prices[d * num_paths + i] = step < knock_step[i] ? scenario[step] : 0.0;
+				}
+				cash_flow_pv[i] = knocked ? 0.0 : disc_exp * opt_.option_payoff(scenario.back());
+			}
+		});
+
+	// (2) Backward induction through the exercise dates:
+	const int num_basis = basis_degree_ + 1;
+	auto basis = [this, spot](double price, Eigen::Ref<VectorXd> phi)
+	{
+		const double x = price / spot;
+		phi[0] = 1.0;
+		for (int k = 1; k <= basis_degree_; ++k) phi[k] = phi[k - 1] * x;
+	};
+
+	std::vector<std::size_t> block_rows(num_blocks + 1);		// First row of each block
+	MatrixXd design;
+	VectorXd continuation;
+
+	for (std::size_t d = num_dates; d-- > 0; )
+	{
+		const int step = exercise_steps_[d];
+		const double disc_date = std::exp(-int_rate_ * step * dt);
+		const double* prices = date_prices.data() + d * num_paths;
+
+		auto exercisable = [&](std::size_t i)
+		{
+			return step < knock_step[i] && opt_.option_payoff(prices[i]) > 0.0;
+		};
+
+		// (3) Regress the continuation value (the path's cash flow, valued at the
+		// exercise date) on the basis, over the paths alive and in the money.
+		// The rows of the design matrix are those paths, in path order: each
+		// block counts its rows, then fills them in from its first row:
+		for_each_block([&](std::size_t block)
+			{
+				auto [first, last] = block_range(block);
+				std::size_t count = 0;
+				for (std::size_t i = first; i < last; ++i)
+				{
+					if (exercisable(i)) ++count;
+				}
+				block_rows[block + 1] = count;
+			});
+		for (std::size_t block = 0; block < num_blocks; ++block)
+		{
+			block_rows[block + 1] += block_rows[block];
+		}
+
+		const std::size_t count = block_rows[num_blocks];
+		if (count <= static_cast<std::size_t>(num_basis)) continue;	// Too few to regress on
+
+		design.resize(count, num_basis);
+		continuation.resize(count);
+		for_each_block([&](std::size_t block)
+			{
+				VectorXd phi(num_basis);
+				auto [first, last] = block_range(block);
+				std::size_t row = block_rows[block];
+				for (std::size_t i = first; i < last; ++i)
+				{
+					if (!exercisable(i)) continue;
+					basis(prices[i], phi);
+					design.row(row) = phi.transpose();
+					continuation[row] = cash_flow_pv[i] / disc_date;
+					++row;
+				}
+			});
+
+		// Least squares by QR of the design matrix itself, rather than of the
+		// normal equations, which would square its condition number:
+		const VectorXd beta = design.colPivHouseholderQr().solve(continuation);
+
+		// (4) Exercise where the payoff beats the estimated continuation value:
+		for_each_block([&](std::size_t block)
+			{
+				VectorXd phi(num_basis);
+				auto [first, last] = block_range(block);
+				for (std::size_t i = first; i < last; ++i)
+				{
+					if (!exercisable(i)) continue;
+					basis(prices[i], phi);
+					const double exercise_value = opt_.option_payoff(prices[i]);
+					if (exercise_value > phi.dot(beta))
+					{
+						cash_flow_pv[i] = disc_date * exercise_value;
+					}
+				}
+			});
+	}
+
+	// (5) Price = mean present value of the cash flows (or immediate
+	// exercise, if that is worth more, for American exercise):
+	RunningStats cash_flows;
+	for (double cf : cash_flow_pv)
+	{
+		cash_flows.add(cf);
+	}
+
+	tmr.stop();
+	MCResult res{cash_flows.mean(), cash_flows.std_error(), num_paths, tmr.milliseconds()};
+	if (american_ && opt_.option_payoff(spot) > res.price)
+	{
+		res.price = opt_.option_payoff(spot);
+		res.std_error = 0.0;
+	}
+	return res;
+}
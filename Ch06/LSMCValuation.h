@@ -0,0 +1,61 @@
+/*
+ * This file is licensed under the Mozilla Public License, v. 2.0.
+ * You can obtain a copy of the license at http://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#include "OptionInfo.h"
+#include "MCOptionValuation.h"		// BarrierType, MCResult
+#include "ThreadPool.h"
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+// Longstaff-Schwartz least-squares Monte Carlo, for options with early
+// exercise (Bermudan, or American, approximated by exercise at every time
+// step), with an optional knock-out barrier monitored at the time steps.
+//
+// Paths come from EquityPriceGenerator, scenario i from the stream
+// Philox4x32{seed, i}, as in MCOptionValuation.  Only the prices at the
+// exercise dates are kept, with the step at which each path knocked out, and
+// the present value of each path's cash flow -- so memory is
+// num_scenarios * (number of exercise dates + 2) values, not whole paths.
+//
+// Going backwards through the exercise dates, the continuation value is
+// regressed on a polynomial in S/spot over the paths that are alive and in
+// the money, and those paths are exercised where the payoff beats it.  The
+// dates depend on each other, so are taken in turn, but the design matrix of
+// each regression is filled in over blocks of paths in parallel (in path
+// order, then solved as a least-squares problem with Eigen's QR), as are the
+// simulation and the exercise update.
+class LSMCValuation
+{
+public:
+	// exercise_steps: the time steps (1, ..., time_steps) at which the option may
+	// be exercised, besides expiration.  Empty means every step (American).
+	LSMCValuation(OptionInfo&& opt, int time_steps, double vol, double int_rate,
+		double div_rate = 0.0, BarrierType barrier_type = BarrierType::none,
+		double barrier_value = 0.0, std::vector<int> exercise_steps = {},
+		int basis_degree = 3);
+
+	MCResult calc_price(double spot, int num_scenarios, unsigned unif_start_seed);
+	MCResult calc_price(double spot, int num_scenarios, unsigned unif_start_seed,
+		ThreadPool& pool);
+
+private:
+	OptionInfo opt_;
+	int time_steps_;
+	double vol_, int_rate_, div_rate_;
+	BarrierType barrier_type_;
+	double barrier_value_;
+	std::vector<int> exercise_steps_;		// Sorted, excluding expiration
+	bool american_;
+	int basis_degree_;
+
+	static constexpr std::size_t paths_per_block = 4096;
+
+	// Common implementation, serial if pool is null:
+	MCResult run_(double spot, int num_scenarios, std::uint64_t seed, ThreadPool* pool) const;
+};
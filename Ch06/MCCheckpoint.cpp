@@ -0,0 +1,134 @@
+/*
+ * This file is licensed under the Mozilla Public License, v. 2.0.
+ * You can obtain a copy of the license at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "MCCheckpoint.h"
+
+#include <fstream>
+#include <stdexcept>
+#include <type_traits>
+#include <system_error>
+#include <string>
+#include <cstring>		// std::memcpy, std::memcmp
+
+namespace
+{
+	constexpr char checkpoint_magic[8] = {'M', 'C', 'C', 'H', 'K', 'P', 'N', 'T'};
+	constexpr std::uint32_t checkpoint_version = 2;
+
+	// Fixed-size start of a checkpoint file, followed by its stats array:
+	struct CheckpointHeader
+	{
+		char magic[8];
+		std::uint32_t version;
+		std::uint32_t reserved;
+		std::uint64_t seed;
+		std::uint64_t num_scenarios;
+		std::uint64_t paths_per_block;
+		std::uint64_t next_block;
+		std::uint64_t num_instruments;
+		double spot;
+		std::uint64_t fingerprint;
+		double elapsed;
+		std::uint64_t steps_simulated;
+		std::uint64_t steps_saved;
+	};
+
+	static_assert(sizeof(CheckpointHeader) == 96);
+	static_assert(std::is_trivially_copyable_v<RunningCovariance::State>);
+}
+
+void write_checkpoint_file(const std::filesystem::path& file_name,
+	const MCCheckpoint& checkpoint)
+{
+	if (checkpoint.stats.size() != checkpoint.num_instruments)
+	{
+		throw std::invalid_argument{"write_checkpoint_file: inconsistent checkpoint"};
+	}
+
+	CheckpointHeader header{};
+	std::memcpy(header.magic, checkpoint_magic, sizeof(header.magic));
+	header.version = checkpoint_version;
+	header.seed = checkpoint.seed;
+	header.num_scenarios = checkpoint.num_scenarios;
+	header.paths_per_block = checkpoint.paths_per_block;
+	header.next_block = checkpoint.next_block;
+	header.num_instruments = checkpoint.num_instruments;
+	header.spot = checkpoint.spot;
+	header.fingerprint = checkpoint.fingerprint;
+	header.elapsed = checkpoint.elapsed;
+	header.steps_simulated = checkpoint.steps_simulated;
+	header.steps_saved = checkpoint.steps_saved;
+
+	std::filesystem::path temp_name = file_name;
+	temp_name += ".tmp";
+	{
+		std::ofstream file{temp_name, std::ios::binary | std::ios::trunc};
+		if (!file)
+		{
+			throw std::runtime_error{"write_checkpoint_file: cannot open " + temp_name.string()};
+		}
+
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		file.write(reinterpret_cast<const char*>(checkpoint.stats.data()),
+			checkpoint.stats.size() * sizeof(RunningCovariance::State));
+
+		file.close();
+		if (!file)
+		{
+			throw std::runtime_error{"write_checkpoint_file: error writing " + temp_name.string()};
+		}
+	}
+
+	// Replaces any previous checkpoint in one step:
+	std::error_code ec;
+	std::filesystem::rename(temp_name, file_name, ec);
+	if (ec)
+	{
+		throw std::runtime_error{"write_checkpoint_file: cannot replace " + file_name.string()
+			+ ": " + ec.message()};
+	}
+}
+
+std::optional<MCCheckpoint> read_checkpoint_file(const std::filesystem::path& file_name)
+{
+	if (!std::filesystem::exists(file_name)) return std::nullopt;
+
+	const std::string name = file_name.string();
+
+	std::ifstream file{file_name, std::ios::binary};
+	std::error_code ec;
+	const std::uintmax_t file_size = std::filesystem::file_size(file_name, ec);
+	if (!file || ec)
+	{
+		throw std::runtime_error{"read_checkpoint_file: cannot open " + name};
+	}
+
+	CheckpointHeader header{};
+	file.read(reinterpret_cast<char*>(&header), sizeof(header));
+	const bool valid = file
+		&& std::memcmp(header.magic, checkpoint_magic, sizeof(header.magic)) == 0
+		&& header.version == checkpoint_version && header.paths_per_block > 0
+		&& header.num_instruments > 0
+		&& header.num_instruments <= file_size / sizeof(RunningCovariance::State)
+		&& file_size == sizeof(CheckpointHeader)
+			+ header.num_instruments * sizeof(RunningCovariance::State);
+	if (!valid)
+	{
+		throw std::runtime_error{"read_checkpoint_file: " + name + " is not a valid checkpoint file"};
+	}
+
+	MCCheckpoint checkpoint{header.seed, header.num_scenarios, header.paths_per_block,
+		header.next_block, header.num_instruments, header.spot, header.fingerprint,
+		header.elapsed, header.steps_simulated, header.steps_saved, {}};
+	checkpoint.stats.resize(header.num_instruments);
+	file.read(reinterpret_cast<char*>(checkpoint.stats.data()),
+		header.num_instruments * sizeof(RunningCovariance::State));
+	if (!file)
+	{
+		throw std::runtime_error{"read_checkpoint_file: error reading " + name};
+	}
+
+	return checkpoint;
+}
@@ -0,0 +1,48 @@
+/*
+ * This file is licensed under the Mozilla Public License, v. 2.0.
+ * You can obtain a copy of the license at http://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#include "RunningStats.h"
+
+#include <filesystem>
+#include <optional>
+#include <vector>
+#include <cstdint>
+
+// The progress of a run of calc_price_checkpointed(.) of MCOptionValuation, or
+// calc_prices_checkpointed(.) of MCPortfolioValuation: the statistics of its
+// first next_block blocks, merged in block order, for each instrument.  As
+// path i draws from the stream Philox4x32{seed, i}, next_block is also the
+// position of the run in its random streams, so the run can resume from here
+// exactly as if it had not stopped.  The fingerprint of the parameters and
+// settings of the valuation (see Fingerprint.h) keeps a run from resuming
+// from the checkpoint of another.
+struct MCCheckpoint
+{
+	std::uint64_t seed{0};
+	std::uint64_t num_scenarios{0};		// Of the whole run
+	std::uint64_t paths_per_block{0};
+	std::uint64_t next_block{0};
+	std::uint64_t num_instruments{0};
+	double spot{0.0};
+	std::uint64_t fingerprint{0};
+	double elapsed{0.0};				// Time (msec) of the run so far, over all attempts
+	std::uint64_t steps_simulated{0};
+	std::uint64_t steps_saved{0};
+
+	// Statistics of the pairs (discounted control, discounted payoff) of each
+	// instrument, as in MCShard:
+	std::vector<RunningCovariance::State> stats;
+};
+
+// The checkpoint is written to a temporary file, which then replaces
+// file_name, so that a crash while writing leaves the previous checkpoint
+// intact.  Reading gives std::nullopt if there is no file.  Both throw
+// std::runtime_error if the file cannot be written or read, or is not a valid
+// checkpoint file:
+void write_checkpoint_file(const std::filesystem::path& file_name,
+	const MCCheckpoint& checkpoint);
+std::optional<MCCheckpoint> read_checkpoint_file(const std::filesystem::path& file_name);
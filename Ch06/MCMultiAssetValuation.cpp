@@ -0,0 +1,128 @@
+/*
+ * This file is licensed under the Mozilla Public License, v. 2.0.
+ * You can obtain a copy of the license at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "MCMultiAssetValuation.h"
+#include "RunningStats.h"
+#include "Timer.h"
+
+#include <utility>		// std::move
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+using Eigen::MatrixXd, Eigen::VectorXd;
+
+MCMultiAssetValuation::MCMultiAssetValuation(std::vector<MultiAssetOption>&& opts,
+	MultiAssetPathGenerator generator) :
+	opts_{std::move(opts)}, generator_{std::move(generator)}
+{
+	for (const auto& opt : opts_)
+	{
+		if (!opt.payoff)
+		{
+			throw std::invalid_argument{"MCMultiAssetValuation: option has no payoff"};
+		}
+		if (opt.aggregate == AssetAggregate::basket && opt.weights.size() != generator_.num_assets())
+		{
+			throw std::invalid_argument{"MCMultiAssetValuation: basket needs one weight per asset"};
+		}
+	}
+}
+
+std::size_t MCMultiAssetValuation::size() const
+{
+	return opts_.size();
+}
+
+std::vector<MCResult> MCMultiAssetValuation::calc_prices(int num_scenarios, unsigned unif_start_seed)
+{
+	return run_(num_scenarios, unif_start_seed, nullptr);
+}
+
+std::vector<MCResult> MCMultiAssetValuation::calc_prices(int num_scenarios, unsigned unif_start_seed,
+	ThreadPool& pool)
+{
+	return run_(num_scenarios, unif_start_seed, &pool);
+}
+
+std::vector<MCResult> MCMultiAssetValuation::run_(int num_scenarios, std::uint64_t seed,
+	ThreadPool* pool) const
+{
+	Timer tmr{};
+	tmr.start();
+
+	const std::size_t num_paths = static_cast<std::size_t>(num_scenarios);
+	const std::size_t num_blocks = (num_paths + paths_per_block - 1) / paths_per_block;
+	const bool need_perf = std::ranges::any_of(opts_, [](const MultiAssetOption& opt)
+		{return opt.aggregate != AssetAggregate::basket;});
+
+	std::vector<std::vector<RunningStats>> block_stats(num_blocks);
+	auto simulate_block = [&](std::size_t block)
+	{
+		const std::size_t first = block * paths_per_block;
+		const auto n = static_cast<Eigen::Index>(std::min(paths_per_block, num_paths - first));
+
+		MatrixXd prices(generator_.num_assets(), n);
+		generator_.terminal_prices(seed, first, prices);
+
+		Eigen::RowVectorXd best, worst;
+		if (need_perf)
+		{
+			const MatrixXd perf = prices.array().colwise() / generator_.spots().array();
+			best = perf.colwise().maxCoeff();
+			worst = perf.colwise().minCoeff();
+		}
+
+		std::vector<RunningStats>& stats = block_stats[block];
+		stats.resize(opts_.size());
+		Eigen::RowVectorXd basket;
+		for (std::size_t k = 0; k < opts_.size(); ++k)
+		{
+			const MultiAssetOption& opt = opts_[k];
+			switch (opt.aggregate)
+			{
+			case AssetAggregate::basket:
+				basket.noalias() = opt.weights.transpose() * prices;
+				break;
+			case AssetAggregate::best_of:
+				basket = best;
+				break;
+			case AssetAggregate::worst_of:
+				basket = worst;
+				break;
+			}
+
+			for (double value : basket)
+			{
+				stats[k].add(opt.payoff->payoff(value));
+			}
+		}
+	};
+
+	if (pool)
+	{
+		pool->parallel_for(num_blocks, simulate_block);
+	}
+	else
+	{
+		for (std::size_t block = 0; block < num_blocks; ++block) simulate_block(block);
+	}
+
+	std::vector<RunningStats> stats(opts_.size());
+	for (const auto& block : block_stats)		// In block order, for reproducibility
+	{
+		for (std::size_t k = 0; k < stats.size(); ++k) stats[k].merge(block[k]);
+	}
+
+	tmr.stop();
+	const double disc = std::exp(-generator_.rf_rate() * generator_.time_to_expiration());
+	std::vector<MCResult> results;
+	results.reserve(stats.size());
+	for (const auto& s : stats)
+	{
+		results.push_back(MCResult{disc * s.mean(), disc * s.std_error(), num_paths, tmr.milliseconds()});
+	}
+	return results;
+}
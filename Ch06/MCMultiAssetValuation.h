@@ -0,0 +1,64 @@
+/*
+ * This file is licensed under the Mozilla Public License, v. 2.0.
+ * You can obtain a copy of the license at http://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#include "MultiAssetPathGenerator.h"
+#include "MCOptionValuation.h"		// MCResult
+#include "Payoffs.h"
+#include "ThreadPool.h"
+
+#include <Eigen/Dense>
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <cstddef>
+
+// How a multi-asset option reduces the prices at expiration to the single
+// value its payoff is applied to:
+enum class AssetAggregate
+{
+	basket,			// Weighted sum of the prices
+	best_of,		// Best performance, S_i(T) / S_i(0) (rainbow)
+	worst_of		// Worst performance, S_i(T) / S_i(0)
+};
+
+// Eg, a basket call is {std::make_unique<CallPayoff>(strike), AssetAggregate::basket,
+// weights}, and a worst-of put struck at 90% is {std::make_unique<PutPayoff>(0.9),
+// AssetAggregate::worst_of}:
+struct MultiAssetOption
+{
+	std::unique_ptr<Payoff> payoff;
+	AssetAggregate aggregate;
+	Eigen::VectorXd weights{};		// One per asset, for AssetAggregate::basket only
+};
+
+// European options on a basket of correlated assets, all expiring with the
+// paths of the generator.  Every option is valued from the same paths: each
+// block of terminal prices is reduced to basket values and best and worst
+// performances with whole-block Eigen operations, then discarded.  Block
+// statistics are merged in block order, so results are the same serially
+// and on a pool.
+class MCMultiAssetValuation
+{
+public:
+	MCMultiAssetValuation(std::vector<MultiAssetOption>&& opts, MultiAssetPathGenerator generator);
+
+	std::size_t size() const;
+
+	// One result per option, in the order given to the constructor:
+	std::vector<MCResult> calc_prices(int num_scenarios, unsigned unif_start_seed);
+	std::vector<MCResult> calc_prices(int num_scenarios, unsigned unif_start_seed, ThreadPool& pool);
+
+private:
+	std::vector<MultiAssetOption> opts_;
+	MultiAssetPathGenerator generator_;
+
+	// Smaller blocks than the single-asset engines, as each path carries a
+	// price per asset:
+	static constexpr std::size_t paths_per_block = 1024;
+
+	std::vector<MCResult> run_(int num_scenarios, std::uint64_t seed, ThreadPool* pool) const;
+};
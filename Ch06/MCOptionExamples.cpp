@@ -6,6 +6,11 @@
 #include "ExampleDeclarations.h"
 #include "Payoffs.h"
 #include "MCOptionValuation.h"
+#include "BlackScholes.h"
+#include "MCPortfolioValuation.h"
+#include "LSMCValuation.h"
+#include "MCMultiAssetValuation.h"
+#include "ScenarioStore.h"
 
 #include <random>				// To check default seed
 #include <memory>
@@ -13,11 +18,26 @@
 #include <iostream>
 #include <iomanip>
 #include <format>
+#include <vector>
+#include <cmath>
+#include <filesystem>
 
 void mc_option_examples()		// Top calling function
 {
 	euro_no_barrier_examples();
 	euro_with_barrier_examples();
+	euro_qmc_examples();
+	euro_variance_reduction_examples();
+	euro_greeks_examples();
+	euro_portfolio_examples();
+	euro_adaptive_examples();
+	american_lsmc_examples();
+	multi_asset_examples();
+	path_model_examples();
+	barrier_mlmc_examples();
+	path_functional_examples();
+	risk_ladder_examples();
+	scenario_store_examples();
 }
 
 void euro_no_barrier_examples()
@@ -94,6 +114,18 @@ void euro_with_barrier_examples()
 	cout << "Option Value = " << val_call_itm_barr_2.calc_price(spot, num_scenarios, seed) << "\n\n";
 	cout << "Analytic solution price = 5.61" << "\n\n";
 
+	// The analytic price is for a continuously monitored barrier; with the
+	// Brownian-bridge crossing correction, 12 time steps are enough:
+	num_time_steps = 12;
+
+	OptionInfo opt_call_itm_barr_3{std::make_unique<CallPayoff>(strike), time_to_exp};
+	MCOptionValuation val_call_itm_barr_3{std::move(opt_call_itm_barr_3),
+		num_time_steps, vol, rate, div, barr_type, barr_val};
+	val_call_itm_barr_3.set_barrier_monitoring(BarrierMonitoring::brownian_bridge);
+
+	cout << "Option Value (12 steps, Brownian-bridge correction) = "
+		<< val_call_itm_barr_3.calc_price(spot, num_scenarios, seed) << "\n\n";
+
 
 	// Extra example: put option.  This is not in this section of the book,
 	// but the example does return in the async tests (task-based concurrency).
@@ -136,3 +168,524 @@ void euro_with_barrier_examples()
 	cout << "Analytic solution price = 6.29" << "\n\n";
 }
 
+void euro_qmc_examples()
+{
+	using std::cout, std::format;
+	cout << "\n" << "*** euro_qmc_examples() ***" << "\n";
+
+	// The up-and-out call from euro_with_barrier_examples(), priced with
+	// pseudo-random and quasi-random (Sobol) scenarios.  The error of each
+	// method is estimated from the spread of the prices over 16 seeds:
+	double strike = 75.0;
+	double spot = 100.0;
+	double vol = 0.25;
+	double rate = 0.05;
+	double div = 0.075;
+	double time_to_exp = 0.5;
+	int num_time_steps = 64;
+	int num_scenarios = 16'384;
+	double barr_val = 110.0;
+
+	auto price_spread = [&](SamplingMethod method, bool bridge)
+	{
+		MCOptionValuation val{OptionInfo{std::make_unique<CallPayoff>(strike), time_to_exp},
+			num_time_steps, vol, rate, div, BarrierType::up_and_out, barr_val};
+		val.set_sampling_method(method, bridge);
+
+		std::vector<double> prices;
+		for (unsigned seed = 1; seed <= 16; ++seed)
+		{
+			prices.push_back(val.calc_price(spot, num_scenarios, seed));
+		}
+
+		double mean = 0.0, var = 0.0;
+		for (double p : prices) mean += p / prices.size();
+		for (double p : prices) var += (p - mean) * (p - mean) / (prices.size() - 1);
+		cout << format("mean price = {:.4f}, std error = {:.5f}\n", mean, std::sqrt(var / prices.size()));
+	};
+
+	cout << "Pseudo-random:                 ";
+	price_spread(SamplingMethod::pseudo_random, false);
+	cout << "Sobol, step by step:           ";
+	price_spread(SamplingMethod::sobol, false);
+	cout << "Sobol with Brownian bridge:    ";
+	price_spread(SamplingMethod::sobol, true);
+	cout << "\n";
+}
+
+void euro_variance_reduction_examples()
+{
+	using std::cout, std::format;
+	cout << "\n" << "*** euro_variance_reduction_examples() ***" << "\n";
+
+	// An up-and-out call, priced with plain Monte Carlo, antithetic paths, and
+	// the vanilla call (Black-Scholes price known) as a control variate:
+	double strike = 75.0;
+	double spot = 100.0;
+	double vol = 0.25;
+	double rate = 0.05;
+	double div = 0.075;
+	double time_to_exp = 0.5;
+	int num_time_steps = 50;
+	int num_scenarios = 50'000;
+	unsigned seed = 42;
+	double barr_val = 130.0;
+
+	auto price_with_error = [&](bool antithetic, bool control_variate)
+	{
+		MCOptionValuation val{OptionInfo{std::make_unique<CallPayoff>(strike), time_to_exp},
+			num_time_steps, vol, rate, div, BarrierType::up_and_out, barr_val};
+		val.set_antithetic(antithetic);
+		if (control_variate) val.set_control_variate(PayoffType::Call, strike);
+
+		MCResult res = val.calc_price_with_error(spot, num_scenarios, seed);
+		cout << format("price = {:.4f}, std error = {:.5f}, paths = {}, time = {:.1f} ms\n",
+			res.price, res.std_error, res.n_paths, res.elapsed);
+	};
+
+	cout << "Plain Monte Carlo:             ";
+	price_with_error(false, false);
+	cout << "Antithetic:                    ";
+	price_with_error(true, false);
+	cout << "Control variate:               ";
+	price_with_error(false, true);
+	cout << "Antithetic + control variate:  ";
+	price_with_error(true, true);
+	cout << "\n";
+}
+
+void euro_greeks_examples()
+{
+	using std::cout, std::format;
+	cout << "\n" << "*** euro_greeks_examples() ***" << "\n";
+
+	double strike = 75.0;
+	double spot = 100.0;
+	double vol = 0.25;
+	double rate = 0.05;
+	double div = 0.075;
+	double time_to_exp = 0.5;
+	int num_time_steps = 24;
+	int num_scenarios = 200'000;
+	unsigned seed = 42;
+
+	auto print_greeks = [](const MCGreeks& g)
+	{
+		cout << format("price = {:.4f} ({:.4f}), delta = {:.4f} ({:.4f}), gamma = {:.5f} ({:.5f}), "
+			"vega = {:.4f} ({:.4f})\n", g.price.price, g.price.std_error, g.delta, g.delta_std_error,
+			g.gamma, g.gamma_std_error, g.vega, g.vega_std_error);
+	};
+
+	// Vanilla call: compare with BlackScholes(strike, spot, time_to_exp, PayoffType::Call,
+	// rate, div).risk_values(vol):
+	MCOptionValuation val_call{OptionInfo{std::make_unique<CallPayoff>(strike), time_to_exp},
+		num_time_steps, vol, rate, div};
+	BlackScholes bsc{strike, spot, time_to_exp, PayoffType::Call, rate, div};
+	auto bs_risk = bsc.risk_values(vol);
+
+	cout << "Call (std errors in brackets):\n";
+	print_greeks(val_call.calc_price_and_greeks(spot, num_scenarios, seed));
+	cout << format("Black-Scholes: price = {:.4f}, delta = {:.4f}, gamma = {:.5f}, vega = {:.4f}\n",
+		bsc(vol), bs_risk[RiskValues::Delta], bs_risk[RiskValues::Gamma], bs_risk[RiskValues::Vega]);
+
+	// Up-and-out call, continuously monitored; all from the same set of paths:
+	MCOptionValuation val_barr{OptionInfo{std::make_unique<CallPayoff>(strike), time_to_exp},
+		num_time_steps, vol, rate, div, BarrierType::up_and_out, 110.0};
+	val_barr.set_barrier_monitoring(BarrierMonitoring::brownian_bridge);
+
+	cout << "Up-and-out call:\n";
+	print_greeks(val_barr.calc_price_and_greeks(spot, num_scenarios, seed));
+
+	// Down-and-out call near its barrier, where the gamma of the smoothed
+	// payoff depends most on spot through the first Brownian-bridge factor:
+	// compare with a central difference of the price, bumping spot and
+	// repricing on the same paths:
+	MCOptionValuation val_down{OptionInfo{std::make_unique<CallPayoff>(100.0), 1.0},
+		50, vol, rate, 0.0, BarrierType::down_and_out, 90.0};
+	val_down.set_barrier_monitoring(BarrierMonitoring::brownian_bridge);
+
+	cout << "Down-and-out call, barrier 90:\n";
+	const double bump = 0.5;
+	for (double near_spot : {92.0, 95.0})
+	{
+		const MCGreeks greeks = val_down.calc_price_and_greeks(near_spot, num_scenarios, seed);
+		const double price_up = val_down.calc_price_and_greeks(near_spot + bump, num_scenarios, seed).price.price;
+		const double price_down = val_down.calc_price_and_greeks(near_spot - bump, num_scenarios, seed).price.price;
+		cout << format("spot = {:.1f}: gamma = {:.5f} ({:.5f}), bump and reprice = {:.5f}\n",
+			near_spot, greeks.gamma, greeks.gamma_std_error,
+			(price_up - 2.0 * greeks.price.price + price_down) / (bump * bump));
+	}
+	cout << "\n";
+}
+
+void euro_portfolio_examples()
+{
+	using std::cout, std::format;
+	cout << "\n" << "*** euro_portfolio_examples() ***" << "\n";
+
+	// A book of calls and up-and-out calls across strikes and expirations,
+	// all valued on one set of 50'000 paths:
+	double spot = 100.0;
+	double vol = 0.25;
+	double rate = 0.05;
+	double div = 0.02;
+	int num_time_steps = 24;
+	int num_scenarios = 50'000;
+	unsigned seed = 42;
+
+	std::vector<OptionInfo> opts;
+	std::vector<BarrierSpec> barriers;
+	for (double time_to_exp : {0.25, 0.5, 1.0})
+	{
+		for (double strike : {90.0, 100.0, 110.0})
+		{
+			opts.emplace_back(std::make_unique<CallPayoff>(strike), time_to_exp);
+			barriers.push_back(BarrierSpec{});
+			opts.emplace_back(std::make_unique<CallPayoff>(strike), time_to_exp);
+			barriers.push_back(BarrierSpec{BarrierType::up_and_out, 130.0});
+		}
+	}
+
+	MCPortfolioValuation book{std::move(opts), barriers, num_time_steps, vol, rate, div};
+	book.set_barrier_monitoring(BarrierMonitoring::brownian_bridge);
+
+	ThreadPool pool{};
+	auto results = book.calc_prices(spot, num_scenarios, seed, pool);
+
+	for (std::size_t k = 0; k < results.size(); k += 2)
+	{
+		cout << format("call = {:.4f} ({:.4f}), up-and-out call = {:.4f} ({:.4f})\n",
+			results[k].price, results[k].std_error, results[k + 1].price, results[k + 1].std_error);
+	}
+	cout << format("{} options, time elapsed (msec) = {:.1f}\n\n", results.size(), results[0].elapsed);
+}
+
+void euro_adaptive_examples()
+{
+	using std::cout, std::format;
+	cout << "\n" << "*** euro_adaptive_examples() ***" << "\n";
+
+	// Rather than a fixed number of scenarios, each valuation runs until its
+	// standard error is within 0.5% of the price, or 500 msec have elapsed:
+	double spot = 100.0;
+	double vol = 0.25;
+	double rate = 0.05;
+	double div = 0.075;
+	double time_to_exp = 0.5;
+	int num_time_steps = 50;
+	unsigned seed = 42;
+
+	StoppingRule rule{.target_rel_error = 0.005, .time_budget = 500.0};
+
+	auto stop_reason = [](StopReason reason)
+	{
+		switch (reason)
+		{
+			case StopReason::target_error: return "target error";
+			case StopReason::time_budget: return "time budget";
+			default: return "max scenarios";
+		}
+	};
+
+	for (double strike : {75.0, 100.0, 125.0})
+	{
+		MCOptionValuation val{OptionInfo{std::make_unique<CallPayoff>(strike), time_to_exp},
+			num_time_steps, vol, rate, div, BarrierType::up_and_out, 140.0};
+		MCResult res = val.calc_price_adaptive(spot, rule, seed);
+		cout << format("strike = {}: price = {:.4f} ({:.4f}), paths = {}, time = {:.1f} ms, stopped by {}\n",
+			strike, res.price, res.std_error, res.n_paths, res.elapsed, stop_reason(res.stop_reason));
+	}
+	cout << "\n";
+}
+
+void american_lsmc_examples()
+{
+	using std::cout, std::format;
+	cout << "\n" << "*** american_lsmc_examples() ***" << "\n";
+
+	// The American put of Longstaff and Schwartz (2001), Table 1, exercisable 50
+	// times a year: finite-difference value $4.478 at spot = 36:
+	double strike = 40.0;
+	double spot = 36.0;
+	double vol = 0.2;
+	double rate = 0.06;
+	double time_to_exp = 1.0;
+	int num_time_steps = 50;
+	int num_scenarios = 100'000;
+	unsigned seed = 42;
+
+	LSMCValuation american_put{OptionInfo{std::make_unique<PutPayoff>(strike), time_to_exp},
+		num_time_steps, vol, rate};
+	MCResult res = american_put.calc_price(spot, num_scenarios, seed);
+
+	BlackScholes euro_put{strike, spot, time_to_exp, PayoffType::Put, rate};
+	cout << format("American put: {:.4f} ({:.4f}), European (Black-Scholes): {:.4f}, time = {:.1f} ms\n",
+		res.price, res.std_error, euro_put(vol), res.elapsed);
+
+	// Bermudan, exercisable at the end of each quarter only:
+	LSMCValuation bermudan_put{OptionInfo{std::make_unique<PutPayoff>(strike), time_to_exp},
+		num_time_steps, vol, rate, 0.0, BarrierType::none, 0.0, {12, 25, 37}};
+	res = bermudan_put.calc_price(spot, num_scenarios, seed);
+	cout << format("Bermudan put (quarterly): {:.4f} ({:.4f})\n", res.price, res.std_error);
+
+	// American down-and-out put, knocked out at 30:
+	LSMCValuation barrier_put{OptionInfo{std::make_unique<PutPayoff>(strike), time_to_exp},
+		num_time_steps, vol, rate, 0.0, BarrierType::down_and_out, 30.0};
+	res = barrier_put.calc_price(spot, num_scenarios, seed);
+	cout << format("American down-and-out put: {:.4f} ({:.4f})\n", res.price, res.std_error);
+
+	cout << "\n";
+}
+
+void multi_asset_examples()
+{
+	using std::cout, std::format;
+	using Eigen::MatrixXd, Eigen::VectorXd;
+	cout << "\n" << "*** multi_asset_examples() ***" << "\n";
+
+	// The four assets of cholesky_correlated_random_equity_paths() in Ch08:
+	MatrixXd cov_basket
+	{
+		{ 0.01263, 0.00025, -0.00017, 0.00503 },
+		{ 0.00025, 0.00138,  0.00280, 0.00027 },
+		{-0.00017, 0.00280,  0.03775, 0.00480 },
+		{ 0.00503, 0.00027,  0.00480, 0.02900 }
+	};
+	VectorXd spots{{100.0, 150.0, 25.0, 50.0}};
+	double rate = 0.01;
+	double time_to_exp = 1.0;
+	int num_time_steps = 12;
+	int num_scenarios = 100'000;
+	unsigned seed = 42;
+
+	// Equal values of each asset, 100 in total:
+	VectorXd weights = 25.0 * spots.cwiseInverse();
+
+	std::vector<MultiAssetOption> opts;
+	opts.push_back({std::make_unique<CallPayoff>(100.0), AssetAggregate::basket, weights});
+	opts.push_back({std::make_unique<CallPayoff>(1.0), AssetAggregate::best_of});
+	opts.push_back({std::make_unique<PutPayoff>(1.0), AssetAggregate::worst_of});
+
+	MCMultiAssetValuation basket{std::move(opts), MultiAssetPathGenerator{spots, cov_basket,
+		time_to_exp, num_time_steps, rate, VectorXd::Zero(4)}};
+	std::vector<MCResult> res = basket.calc_prices(num_scenarios, seed);
+	cout << format("Basket call: {:.4f} ({:.4f}), best-of call: {:.4f} ({:.4f}), worst-of put: {:.4f} ({:.4f})\n",
+		res[0].price, res[0].std_error, res[1].price, res[1].std_error, res[2].price, res[2].std_error);
+
+	// A 50-asset basket, pairwise correlation 0.3, vols from 15% to 40%:
+	const int num_assets = 50;
+	VectorXd vols = VectorXd::LinSpaced(num_assets, 0.15, 0.40);
+	MatrixXd corr = MatrixXd::Constant(num_assets, num_assets, 0.3);
+	corr.diagonal().setOnes();
+	MatrixXd cov = vols.asDiagonal() * corr * vols.asDiagonal();
+
+	opts.clear();
+	opts.push_back({std::make_unique<CallPayoff>(100.0), AssetAggregate::basket,
+		VectorXd::Constant(num_assets, 1.0 / num_assets)});
+	opts.push_back({std::make_unique<PutPayoff>(1.0), AssetAggregate::worst_of});
+
+	MCMultiAssetValuation big_basket{std::move(opts), MultiAssetPathGenerator{
+		VectorXd::Constant(num_assets, 100.0), cov, time_to_exp, num_time_steps, rate,
+		VectorXd::Zero(num_assets)}};
+	res = big_basket.calc_prices(num_scenarios, seed);
+	cout << format("50 assets: basket call: {:.4f} ({:.4f}), worst-of put: {:.4f} ({:.4f}), time = {:.1f} ms\n",
+		res[0].price, res[0].std_error, res[1].price, res[1].std_error, res[0].elapsed);
+
+	cout << "\n";
+}
+
+void path_model_examples()
+{
+	using std::cout, std::format;
+	cout << "\n" << "*** path_model_examples() ***" << "\n";
+
+	double strike = 100.0;
+	double spot = 100.0;
+	double vol = 0.2;		// Black-Scholes comparison only; not used by the models
+	double rate = 0.05;
+	double div = 0.02;
+	double time_to_exp = 1.0;
+	int num_time_steps = 12;
+	int num_scenarios = 200'000;
+	unsigned seed = 42;
+
+	MCOptionValuation val{OptionInfo{std::make_unique<CallPayoff>(strike), time_to_exp},
+		num_time_steps, vol, rate, div};
+
+	BlackScholes bsc{strike, spot, time_to_exp, PayoffType::Call, rate, div};
+	cout << format("Black-Scholes, vol = {}: {:.4f}\n", vol, bsc(vol));
+
+	// v0 = theta = 0.04 (20% vol), kappa = 1.5, vol of variance 0.6, rho = -0.7.
+	// The semi-analytic (Fourier) price is $8.4120:
+	HestonModel heston{0.04, 1.5, 0.04, 0.6, -0.7};
+	MCResult res = val.calc_price_with_model(spot, num_scenarios, seed, heston);
+	cout << format("Heston (QE): {:.4f} ({:.4f})\n", res.price, res.std_error);
+
+	// With beta = 0.5, alpha0 = 2 is about 20% lognormal vol at S = 100:
+	SABRModel sabr{2.0, 0.5, 0.4, -0.3};
+	res = val.calc_price_with_model(spot, num_scenarios, seed, sabr);
+	cout << format("SABR: {:.4f} ({:.4f})\n", res.price, res.std_error);
+
+	// A skew constant in time, 30% vol at 80 down to 15% at 120:
+	LocalVolModel local_vol{{0.0}, {80.0, 100.0, 120.0}, {0.30, 0.20, 0.15}};
+	res = val.calc_price_with_model(spot, num_scenarios, seed, local_vol);
+	cout << format("Local vol: {:.4f} ({:.4f})\n", res.price, res.std_error);
+
+	cout << "\n";
+}
+
+void barrier_mlmc_examples()
+{
+	using std::cout, std::format;
+	cout << "\n" << "*** barrier_mlmc_examples() ***" << "\n";
+
+	// A 10 year down-and-out put, monitored daily (2520 time steps):
+	double strike = 105.0;
+	double spot = 100.0;
+	double vol = 0.25;
+	double rate = 0.05;
+	double div = 0.08;
+	double time_to_exp = 10.0;
+	int num_time_steps = 10 * 252;
+	unsigned seed = 42;
+	double target_std_error = 0.02;
+
+	MCOptionValuation val{OptionInfo{std::make_unique<PutPayoff>(strike), time_to_exp},
+		num_time_steps, vol, rate, div, BarrierType::down_and_out, 50.0};
+
+	MCResult res = val.calc_price_mlmc(spot, target_std_error, seed);
+	cout << format("MLMC: {:.4f} ({:.4f}), samples = {}, steps = {}, time = {:.1f} ms\n",
+		res.price, res.std_error, res.n_paths, res.steps_simulated, res.elapsed);
+
+	// Single level, run to the same standard error.  The GBM steps are exact, so
+	// MLMC only gains a constant factor here (about 1.5 in time, with a third
+	// of the steps), rather than a better order in the target error:
+	StoppingRule rule{.target_abs_error = target_std_error};
+	res = val.calc_price_adaptive(spot, rule, seed);
+	cout << format("Single level: {:.4f} ({:.4f}), paths = {}, steps = {}, time = {:.1f} ms\n",
+		res.price, res.std_error, res.n_paths, res.steps_simulated, res.elapsed);
+
+	cout << "\n";
+}
+
+void path_functional_examples()
+{
+	using std::cout, std::format;
+	cout << "\n" << "*** path_functional_examples() ***" << "\n";
+
+	double spot = 100.0;
+	double vol = 0.2;
+	double rate = 0.05;
+	double div = 0.02;
+	double time_to_exp = 1.0;
+	int num_time_steps = 12;		// Monthly averaging and monitoring dates
+	int num_scenarios = 200'000;
+	unsigned seed = 42;
+
+	// The payoff of the OptionInfo is not used; only its time to expiration:
+	MCOptionValuation val{OptionInfo{std::make_unique<CallPayoff>(100.0), time_to_exp},
+		num_time_steps, vol, rate, div};
+
+	// The geometric Asian is priced in closed form (its own control variate),
+	// and serves as the control variate for the arithmetic Asian:
+	AsianOption geometric_asian{PayoffType::Call, 100.0, AsianAverage::geometric};
+	MCResult res = val.calc_price_path_functional(spot, num_scenarios, seed, geometric_asian);
+	cout << format("Geometric Asian call: {:.4f}\n", res.price);
+
+	AsianOption asian{PayoffType::Call, 100.0};
+	res = val.calc_price_path_functional(spot, num_scenarios, seed, asian);
+	cout << format("Arithmetic Asian call: {:.4f} ({:.5f})\n", res.price, res.std_error);
+
+	LookbackOption lookback{PayoffType::Call, LookbackStrike::floating};
+	res = val.calc_price_path_functional(spot, num_scenarios, seed, lookback);
+	cout << format("Floating strike lookback call: {:.4f} ({:.4f})\n", res.price, res.std_error);
+
+	RangeAccrual range_accrual{90.0, 110.0, 100.0};
+	res = val.calc_price_path_functional(spot, num_scenarios, seed, range_accrual);
+	cout << format("Range accrual [90, 110], notional 100: {:.4f} ({:.4f})\n",
+		res.price, res.std_error);
+
+	cout << "\n";
+}
+
+void risk_ladder_examples()
+{
+	using std::cout, std::format;
+	cout << "\n" << "*** risk_ladder_examples() ***" << "\n";
+
+	// The down-and-out put of perf_tests_euro_with_barrier_examples(.), on a
+	// grid of spot and vol bumps, all priced from the same scenarios:
+	double strike = 105.0;
+	double vol = 0.25;
+	double rate = 0.05;
+	double div = 0.08;
+	double time_to_exp = 1.0;
+	int num_time_steps = 50;
+	int num_scenarios = 50'000;
+	unsigned seed = 42;
+
+	MCOptionValuation val{OptionInfo{std::make_unique<PutPayoff>(strike), time_to_exp},
+		num_time_steps, vol, rate, div, BarrierType::down_and_out, 70.5};
+
+	std::vector<double> spots{90.0, 95.0, 100.0, 105.0, 110.0};
+	std::vector<double> vols{0.20, 0.25, 0.30};
+	MCLadder ladder = val.calc_price_ladder(spots, vols, num_scenarios, seed);
+
+	cout << "Spot \\ vol";
+	for (double v : vols) cout << format("{:>10.2f}", v);
+	cout << "\n";
+	for (std::size_t i = 0; i < spots.size(); ++i)
+	{
+		cout << format("{:>10.1f}", spots[i]);
+		for (std::size_t j = 0; j < vols.size(); ++j)
+		{
+			cout << format("{:>10.4f}", ladder.result(i, j).price);
+		}
+		cout << "\n";
+	}
+	cout << format("{} grid points in {:.1f} ms\n", spots.size() * vols.size(), ladder.elapsed);
+
+	cout << "\n";
+}
+
+void scenario_store_examples()
+{
+	using std::cout, std::format;
+	cout << "\n" << "*** scenario_store_examples() ***" << "\n";
+
+	// The scenarios are simulated and written once; each valuation then reads
+	// them in place, rather than simulating its own:
+	double spot = 100.0;
+	double vol = 0.25;
+	double rate = 0.05;
+	double div = 0.08;
+	double time_to_exp = 1.0;
+	int num_time_steps = 50;
+	int num_scenarios = 50'000;
+	unsigned seed = 42;
+
+	const auto file_name = std::filesystem::temp_directory_path() / "mc_scenarios.bin";
+	write_scenario_file(file_name, spot, num_time_steps, time_to_exp, vol, rate, div,
+		num_scenarios, seed);
+
+	{
+		ScenarioFile scenarios{file_name};
+
+		MCOptionValuation barrier_put{OptionInfo{std::make_unique<PutPayoff>(105.0), time_to_exp},
+			num_time_steps, vol, rate, div, BarrierType::down_and_out, 70.5};
+		MCOptionValuation barrier_call{OptionInfo{std::make_unique<CallPayoff>(95.0), time_to_exp},
+			num_time_steps, vol, rate, div, BarrierType::up_and_out, 141.0};
+
+		for (auto* val : {&barrier_put, &barrier_call})
+		{
+			MCResult simulated = val->calc_price_with_error(spot, num_scenarios, seed);
+			MCResult stored = val->calc_price_from_scenarios(scenarios);
+			cout << format("Simulated: {:.6f} ({:.1f} ms), stored: {:.6f} ({:.1f} ms)\n",
+				simulated.price, simulated.elapsed, stored.price, stored.elapsed);
+		}
+	}
+
+	std::filesystem::remove(file_name);
+
+	cout << "\n";
+}
\ No newline at end of file
@@ -7,6 +7,7 @@
 #include "Timer.h"
 #include "Payoffs.h"
 #include "MCOptionValuation.h"
+#include "ThreadPool.h"
 
 #include <memory>
 #include <utility>
@@ -99,5 +100,29 @@ void perf_tests_euro_with_barrier_examples(double time_to_exp, int num_time_step
 	tmr.stop();
 	msec_elapsed = tmr.milliseconds();
 	cout << std::fixed << std::setprecision(2) << "Option Value (with async) = " << opt_val << "\n";
+	cout << format("Time elapsed (msec) = {}\n", msec_elapsed);
+
+	// The pool's threads are started before the clock, as they would
+	// be reused across valuations:
+	ThreadPool pool{};
+	print_this("Euro option with barrier thread pool start clock\n");
+	tmr.start();
+	MCResult res = val_put_itm_not_exp.calc_price_with_error(spot, num_scenarios, seed, pool);
+	tmr.stop();
+	msec_elapsed = tmr.milliseconds();
+	cout << std::fixed << std::setprecision(2) << "Option Value (thread pool) = " << res.price
+		<< ", std error = " << std::setprecision(4) << res.std_error << "\n";
+	cout << format("Time steps simulated = {}, saved by knock-out exit = {}\n",
+		res.steps_simulated, res.steps_saved);
+	cout << format("Time elapsed (msec) = {}\n", msec_elapsed);
+
+	val_put_itm_not_exp.set_path_backend(PathBackend::batch);
+	print_this("Euro option with barrier batch (SIMD) paths start clock\n");
+	tmr.start();
+	res = val_put_itm_not_exp.calc_price_with_error(spot, num_scenarios, seed, pool);
+	tmr.stop();
+	msec_elapsed = tmr.milliseconds();
+	cout << std::fixed << std::setprecision(2) << "Option Value (batch paths) = " << res.price
+		<< ", std error = " << std::setprecision(4) << res.std_error << "\n";
 	cout << format("Time elapsed (msec) = {}\n\n", msec_elapsed);
 }
\ No newline at end of file
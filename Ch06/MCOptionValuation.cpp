@@ -5,15 +5,26 @@
 
 #include "MCOptionValuation.h"
 #include "EquityPriceGenerator.h"
+#include "BatchEquityPriceGenerator.h"
+#include "Philox.h"
+#include "NormalSamplers.h"
+#include "RunningStats.h"
+#include "Timer.h"
+#include "ScenarioStore.h"
+#include "Fingerprint.h"
 
 #include <utility>			// std::move
 #include <cmath>
 #include <vector>
-#include <algorithm>		// std::find_if
+#include <array>
+#include <limits>
+#include <chrono>
+#include <algorithm>		// std::find_if, std::min
+#include <cstddef>
 #include <ranges>			// std::ranges::find_if
-#include <numeric>			// std::accumulate
 #include <random>
 #include <future>
+#include <stdexcept>
 
 // This is the form of the constructor for the European option
 // example as shown at the outset of the section in the Chapter.
@@ -43,22 +54,30 @@ double MCOptionValuation::calc_price_euro(double spot, int num_scenarios, unsign
 		std::mt19937_64 mt_unif{unif_start_seed};
 		std::uniform_int_distribution<unsigned> unif_int_dist{};	// (2)
 
-		vector<double> discounted_payoffs;							// (3)
-		discounted_payoffs.reserve(num_scenarios);
+		RunningStats discounted_payoffs;							// (3)
 		const double disc_factor = std::exp(-int_rate_ * opt_.time_to_expiration());
 
+		EquityPriceGenerator epg{spot, time_steps_, opt_.time_to_expiration(), vol_,
+			int_rate_, div_rate_};									// (5)
+		vector<double> scenario(time_steps_ + 1);		// Reused by every scenario
+
 		for (int i = 0; i < num_scenarios; ++i)						// (4)
 		{
-			EquityPriceGenerator epg{spot, time_steps_, opt_.time_to_expiration(), vol_,
-				int_rate_, div_rate_};								// (5)
-			vector scenario = epg(unif_int_dist(mt_unif));	// (unif_int_dist(mt_unif): next seed)
+			if (opt_.path_dependence() == PathDependence::terminal_only)
+			{
+				// Only S(T) is needed, so it is drawn directly:
+				discounted_payoffs.add(disc_factor
+					* opt_.option_payoff(epg.terminal_price(unif_int_dist(mt_unif))));
+				continue;
+			}
+
+			epg(unif_int_dist(mt_unif), scenario);		// (unif_int_dist(mt_unif): next seed)
 
-			discounted_payoffs.push_back(disc_factor
+			discounted_payoffs.add(disc_factor
 				* opt_.option_payoff(scenario.back())); 			// (6)
 		}
 
-		return (1.0 / num_scenarios) * std::accumulate(discounted_payoffs.cbegin(),
-			discounted_payoffs.cend(), 0.0);						// (7)
+		return discounted_payoffs.mean();							// (7)
 	}
 	else
 	{
@@ -68,82 +87,50 @@ double MCOptionValuation::calc_price_euro(double spot, int num_scenarios, unsign
 
 double MCOptionValuation::calc_price(double spot, int num_scenarios, unsigned unif_start_seed)
 {
-	bool barrier_hit =
-		(barrier_type_ == BarrierType::up_and_out && spot >= barrier_value_) ||
-		(barrier_type_ == BarrierType::down_and_out && spot <= barrier_value_);		// (1)
+	return calc_price_with_error(spot, num_scenarios, unif_start_seed).price;
+}
+
+MCResult MCOptionValuation::calc_price_with_error(double spot, int num_scenarios,
+	unsigned unif_start_seed)
+{
+	Timer tmr{};
+	tmr.start();
+
+	bool barrier_hit = spot_knocked_out_(spot);		// (1)
 
-	if (barrier_hit) return 0.0;	// Option is worthless		// (2)
+	if (barrier_hit) return MCResult{};	// Option is worthless	// (2)
 
 	// Case where barrier has not (yet) been crossed
 
 	if (opt_.time_to_expiration() > 0 )							// (3)
-	{		
-		std::mt19937_64 mt_unif{unif_start_seed};				// (4)
-		std::uniform_int_distribution<unsigned> unif_int_dist{};
-		const double disc_factor = std::exp(-int_rate_ * opt_.time_to_expiration());
-		
-		using std::vector;
-		vector<double> discounted_payoffs;						// (5)
-		discounted_payoffs.reserve(num_scenarios);
+	{
+		// Scenario i is generated from the counter-based stream
+		// Philox4x32{unif_start_seed, i} (or Sobol point i), in blocks of paths_per_block:
+		prepare_sampling_(unif_start_seed);
+		const std::size_t num_blocks = (num_scenarios + paths_per_block - 1) / paths_per_block;
 
-		// Iteration starts with barrier_hit = false
-		for (int i = 0; i < num_scenarios; ++i)					// (6)
+		BlockStats discounted_payoffs;							// (4)
+		for (std::size_t block = 0; block < num_blocks; ++block)
 		{
-			EquityPriceGenerator epg{spot, time_steps_, opt_.time_to_expiration(), vol_,
-				int_rate_, div_rate_};
-			vector scenario = epg(unif_int_dist(mt_unif));		// (7)
-
-			switch (barrier_type_)								// (8)
-			{
-				case BarrierType::none: break;					// (9)					
-
-				case BarrierType::up_and_out:					// (10)
-				{
-					auto barrier_hit_pos = std::find_if(scenario.cbegin(), scenario.cend(),
-						[this](double sim_eq) {return sim_eq >= barrier_value_;});	// (11)
-					if (barrier_hit_pos != scenario.cend()) barrier_hit = true;		// (12)
-				}
-				break;
-
-				case BarrierType::down_and_out:					// (13)
-				{
-					auto barrier_hit_pos = std::ranges::find_if(scenario,
-						[this](double sim_eq) {return sim_eq <= barrier_value_;});	// (14)
-					if (barrier_hit_pos != scenario.cend()) barrier_hit = true;
-				}
-				break;				
-			
-			}	// end of switch statement					
-
-			if (barrier_hit)
-			{
-				discounted_payoffs.push_back(0.0);				// (15)
-			}
-			else
-			{
-				discounted_payoffs.push_back(disc_factor * opt_.option_payoff(scenario.back())); // (16)
-			}
-
-			barrier_hit = false;								// (17)
-		}		
+			discounted_payoffs.merge(simulate_block_(spot, num_scenarios,
+				unif_start_seed, block));						// (5)
+		}
 
-		// Option value = mean of discounted payoffs
-		return (1.0 / num_scenarios) * std::accumulate(discounted_payoffs.cbegin(),
-			discounted_payoffs.cend(), 0.0);					// (18)		
+		// Option value = mean of discounted payoffs (less the control variate adjustment)
+		tmr.stop();
+		return make_result_(discounted_payoffs, spot, tmr.milliseconds());	// (6)
 	}
-	else														// (19)
+	else														// (7)
 	{
 		// At expiration, barrier_hit == false
-		return opt_.option_payoff(spot);						// (20)
+		return MCResult{opt_.option_payoff(spot)};				// (8)
 	}
 }
 
 
 double MCOptionValuation::calc_price_par(double spot, int num_scenarios, unsigned unif_start_seed)
 {
-	bool barrier_hit =
-		(barrier_type_ == BarrierType::up_and_out && spot >= barrier_value_) ||
-		(barrier_type_ == BarrierType::down_and_out && spot <= barrier_value_);		
+	bool barrier_hit = spot_knocked_out_(spot);
 
 	if (barrier_hit) return 0.0;	// Option is worthless		
 
@@ -157,8 +144,7 @@ double MCOptionValuation::calc_price_par(double spot, int num_scenarios, unsigne
 		std::mt19937_64 mt_unif{unif_start_seed};
 		std::uniform_int_distribution<unsigned> unif_int_dist{};
 
-		vector<double> discounted_payoffs;
-		discounted_payoffs.reserve(num_scenarios);
+		RunningStats discounted_payoffs;
 		const double disc_factor = std::exp(-int_rate_ * opt_.time_to_expiration());
 
 		vector<std::future<vector<double>>> ftrs;							// (1)
@@ -208,22 +194,1559 @@ double MCOptionValuation::calc_price_par(double spot, int num_scenarios, unsigne
 
 				if (barrier_hit)
 				{
-					discounted_payoffs.push_back(0.0);
+					discounted_payoffs.add(0.0);
 				}
 				else
 				{
-					discounted_payoffs.push_back(disc_factor * opt_.option_payoff(scenario.back()));
+					discounted_payoffs.add(disc_factor * opt_.option_payoff(scenario.back()));
 				}
 
 				barrier_hit = false;
 			}
 		}
 
-		return (1.0 / num_scenarios) * std::accumulate(discounted_payoffs.cbegin(),
-			discounted_payoffs.cend(), 0.0);
+		return discounted_payoffs.mean();
 	}
 	else
 	{
 		return opt_.option_payoff(spot);
 	}
-}
\ No newline at end of file
+}
+
+double MCOptionValuation::calc_price_par(double spot, int num_scenarios, unsigned unif_start_seed,
+	ThreadPool& pool)
+{
+	return calc_price_with_error(spot, num_scenarios, unif_start_seed, pool).price;
+}
+
+MCResult MCOptionValuation::calc_price_with_error(double spot, int num_scenarios,
+	unsigned unif_start_seed, ThreadPool& pool)
+{
+	Timer tmr{};
+	tmr.start();
+
+	if (spot_knocked_out_(spot)) return MCResult{};	// Option is worthless
+
+	if (opt_.time_to_expiration() > 0)
+	{
+		// The same blocks as the serial version, each run as a pool task.  There are
+		// many more blocks than workers, so idle workers steal from busy ones:
+		prepare_sampling_(unif_start_seed);
+		const std::size_t num_blocks = (num_scenarios + paths_per_block - 1) / paths_per_block;
+		std::vector<BlockStats> block_stats(num_blocks);							// (1)
+
+		pool.parallel_for(num_blocks, [&](std::size_t block)						// (2)
+			{
+				// Each block writes only its own slot:
+				block_stats[block] = simulate_block_(spot, num_scenarios, unif_start_seed, block);
+			});
+
+		// Merging in block order (rather than in order of completion) makes the
+		// result identical to the serial version, whatever the number of threads:
+		BlockStats discounted_payoffs;
+		for (const auto& stats : block_stats)
+		{
+			discounted_payoffs.merge(stats);										// (3)
+		}
+
+		tmr.stop();
+		return make_result_(discounted_payoffs, spot, tmr.milliseconds());
+	}
+	else
+	{
+		return MCResult{opt_.option_payoff(spot)};
+	}
+}
+
+MCResult MCOptionValuation::calc_price_adaptive(double spot, const StoppingRule& rule,
+	unsigned unif_start_seed)
+{
+	return run_adaptive_(spot, rule, unif_start_seed, nullptr);
+}
+
+MCResult MCOptionValuation::calc_price_adaptive(double spot, const StoppingRule& rule,
+	unsigned unif_start_seed, ThreadPool& pool)
+{
+	return run_adaptive_(spot, rule, unif_start_seed, &pool);
+}
+
+MCResult MCOptionValuation::run_adaptive_(double spot, const StoppingRule& rule,
+	std::uint64_t seed, ThreadPool* pool)
+{
+	Timer tmr{};
+	tmr.start();
+
+	if (spot_knocked_out_(spot)) return MCResult{};	// Option is worthless
+	if (opt_.time_to_expiration() <= 0.0) return MCResult{opt_.option_payoff(spot)};
+
+	prepare_sampling_(seed);
+
+	const std::uint64_t min_scenarios = static_cast<std::uint64_t>(std::max(rule.min_scenarios, 0));
+	auto target_met = [&rule, min_scenarios](const MCResult& res)
+	{
+		if (res.n_paths < min_scenarios) return false;
+		return (rule.target_abs_error > 0.0 && res.std_error <= rule.target_abs_error)
+			|| (rule.target_rel_error > 0.0 && res.std_error > 0.0
+				&& res.std_error <= rule.target_rel_error * std::abs(res.price));
+	};
+
+	using clock = std::chrono::steady_clock;
+	const auto deadline = clock::now() + std::chrono::duration<double, std::milli>{rule.time_budget};
+	auto out_of_time = [&rule, deadline] {return rule.time_budget > 0.0 && clock::now() >= deadline;};
+
+	// The error targets are tested after each block, in block order, and the
+	// time budget after each batch (see run_blocks_in_order(.)):
+	const std::size_t max_scenarios = static_cast<std::size_t>(std::max(rule.max_scenarios, 0));
+	const std::size_t num_blocks = (max_scenarios + paths_per_block - 1) / paths_per_block;
+
+	BlockStats discounted_payoffs;
+	MCResult res;
+	bool met = false;
+	const std::size_t next_block = run_blocks_in_order(pool, 0, num_blocks,
+		[&](std::size_t block) {return simulate_block_(spot, max_scenarios, seed, block);},
+		[&](std::size_t, BlockStats&& stats)
+		{
+			discounted_payoffs.merge(stats);
+			tmr.stop();
+			res = make_result_(discounted_payoffs, spot, tmr.milliseconds());
+			met = target_met(res);
+			return !met;
+		},
+		out_of_time);
+
+	tmr.stop();
+	res = make_result_(discounted_payoffs, spot, tmr.milliseconds());
+	if (met) res.stop_reason = StopReason::target_error;
+	else if (next_block < num_blocks) res.stop_reason = StopReason::time_budget;
+	return res;
+}
+
+MCResult MCOptionValuation::calc_price_mlmc(double spot, double target_std_error,
+	unsigned unif_start_seed)
+{
+	return run_mlmc_(spot, target_std_error, unif_start_seed, nullptr);
+}
+
+MCResult MCOptionValuation::calc_price_mlmc(double spot, double target_std_error,
+	unsigned unif_start_seed, ThreadPool& pool)
+{
+	return run_mlmc_(spot, target_std_error, unif_start_seed, &pool);
+}
+
+MCResult MCOptionValuation::run_mlmc_(double spot, double target_std_error, std::uint64_t seed,
+	ThreadPool* pool) const
+{
+	if (target_std_error <= 0.0)
+	{
+		throw std::invalid_argument{"MCOptionValuation: MLMC needs a positive target std error"};
+	}
+
+	Timer tmr{};
+	tmr.start();
+
+	if (spot_knocked_out_(spot)) return MCResult{};	// Option is worthless
+	if (opt_.time_to_expiration() <= 0.0) return MCResult{opt_.option_payoff(spot)};
+
+	// (1) Level l monitors the dates of the full grid that are multiples of
+	// 2^(L - l) steps, and expiration, where 2^L is the first power of two of at
+	// least time_steps_, so that level 0 is expiration alone.  Without a barrier,
+	// only S(T) matters, and level 0 alone is exact:
+	int top_level = 0;
+	while ((1 << top_level) < time_steps_) ++top_level;
+	const std::size_t num_levels = barrier_type_ != BarrierType::none ? top_level + 1 : 1;
+
+	std::vector<BlockStats> levels(num_levels);
+	std::vector<std::size_t> target_samples(num_levels, initial_mlmc_samples);
+
+	// (2) Brings each level up to its target number of samples, in blocks:
+	auto run_levels = [&]
+	{
+		struct Block
+		{
+			std::size_t level, first, last;
+		};
+		std::vector<Block> blocks;
+		for (std::size_t l = 0; l < num_levels; ++l)
+		{
+			for (std::size_t first = levels[l].payoffs.count(); first < target_samples[l];
+				first += paths_per_block)
+			{
+				blocks.push_back({l, first, std::min(first + paths_per_block, target_samples[l])});
+			}
+		}
+
+		std::vector<BlockStats> block_stats(blocks.size());
+		auto run_block = [&](std::size_t k)
+		{
+			const Block& b = blocks[k];
+			block_stats[k] = simulate_mlmc_block_(spot, static_cast<int>(b.level),
+				1 << (top_level - b.level), seed, b.first, b.last);
+		};
+
+		if (pool)
+		{
+			pool->parallel_for(blocks.size(), run_block);
+		}
+		else
+		{
+			for (std::size_t k = 0; k < blocks.size(); ++k) run_block(k);
+		}
+
+		for (std::size_t k = 0; k < blocks.size(); ++k)		// In order, for reproducibility
+		{
+			levels[blocks[k].level].merge(block_stats[k]);
+		}
+	};
+
+	// (3) Giles' allocation: N_l proportional to sqrt(V_l / C_l) minimizes the
+	// total cost sum(N_l C_l) for a variance sum(V_l / N_l) = target^2, where V_l
+	// is the variance of the level's samples and C_l their cost.  C_l is the
+	// mean cost of the samples so far, in plain steps, as conditioned steps cost
+	// several times more, and how many of them a sample takes depends on how
+	// near the barrier its paths come.  It is counted rather than timed, so
+	// that the allocation, and the result, are reproducible:
+	std::vector<double> level_cost(num_levels);
+	for (bool more = true; more; )
+	{
+		run_levels();
+
+		for (std::size_t l = 0; l < num_levels; ++l)
+		{
+			level_cost[l] = (levels[l].steps_simulated
+				+ (conditioned_step_cost - 1.0) * levels[l].steps_conditioned)
+				/ static_cast<double>(levels[l].payoffs.count());
+		}
+
+		double sum_sqrt_vc = 0.0;
+		for (std::size_t l = 0; l < num_levels; ++l)
+		{
+			sum_sqrt_vc += std::sqrt(levels[l].payoffs.y().variance() * level_cost[l]);
+		}
+
+		more = false;
+		for (std::size_t l = 0; l < num_levels; ++l)
+		{
+			const double v_over_c = levels[l].payoffs.y().variance() / level_cost[l];
+			const double optimal = std::ceil(std::sqrt(v_over_c) * sum_sqrt_vc
+				/ (target_std_error * target_std_error));
+			if (optimal > static_cast<double>(target_samples[l]))
+			{
+				target_samples[l] = static_cast<std::size_t>(optimal);
+				more = true;
+			}
+		}
+	}
+
+	// (4) The price is the sum of the level means, with variance sum(V_l / N_l):
+	MCResult res;
+	double variance = 0.0;
+	for (const BlockStats& level : levels)
+	{
+		const RunningStats& diffs = level.payoffs.y();
+		res.price += diffs.mean();
+		variance += diffs.variance() / diffs.count();
+		res.n_paths += diffs.count();
+		res.steps_simulated += level.steps_simulated;
+		res.steps_saved += level.steps_saved;
+	}
+	res.std_error = std::sqrt(variance);
+
+	tmr.stop();
+	res.elapsed = tmr.milliseconds();
+	return res;
+}
+
+MCOptionValuation::BlockStats MCOptionValuation::simulate_mlmc_block_(double spot, int level,
+	int stride, std::uint64_t seed, std::size_t first, std::size_t last) const
+{
+	// The dates of the level are steps of stride * dt, and expiration, which
+	// ends a shorter step if time_steps_ is not a multiple of the stride:
+	const double time_to_exp = opt_.time_to_expiration();
+	const double step_time = stride * time_to_exp / time_steps_;
+	const int num_dates = (time_steps_ + stride - 1) / stride;
+	const double disc_factor = std::exp(-int_rate_ * time_to_exp);
+
+	std::vector<double> fine_dt(num_dates, step_time);
+	fine_dt.back() = time_to_exp - (num_dates - 1) * step_time;
+
+	// The coarse path (the level below) steps over pairs of fine steps, and over
+	// the last one alone if there is an odd number of them:
+	std::vector<double> coarse_dt(level > 0 ? (num_dates + 1) / 2 : 0);
+	for (std::size_t j = 0; j < coarse_dt.size(); ++j)
+	{
+		coarse_dt[j] = fine_dt[2 * j] + (2 * j + 1 < fine_dt.size() ? fine_dt[2 * j + 1] : 0.0);
+	}
+
+	// One-step survival (Glasserman-Staum): each step is drawn conditional on
+	// the price at its end not being at or beyond the barrier, and the path is
+	// weighted by the probability of that.  A path then never knocks out, and
+	// the weighted payoff is a smooth function of the normals driving it, so
+	// that fine and coarse paths built from the same normals stay close.
+	// Returns the survival probability of the step, and moves on the log price:
+	const double drift = int_rate_ - div_rate_ - vol_ * vol_ / 2.0;
+	const double log_barrier = barrier_type_ != BarrierType::none ? std::log(barrier_value_) : 0.0;
+	auto normal_cdf = [](double x) {return 0.5 * std::erfc(-x / std::sqrt(2.0));};
+	auto clamp_prob = [](double p)
+	{
+		return std::clamp(p, std::numeric_limits<double>::min(), 1.0 - std::numeric_limits<double>::epsilon());
+	};
+
+	// Beyond this many standard deviations from the barrier, a step is drawn
+	// unconditioned, and knocks out if it ends at or beyond the barrier, which
+	// happens with a probability below 3e-7.  That is still exact, and keeps the
+	// costlier conditioned steps to the paths near the barrier:
+	constexpr double far_from_barrier = 5.0;
+
+	std::uint64_t steps_conditioned = 0;
+	auto conditional_step = [&](double& log_price, double dt, double sqrt_dt, double z)
+	{
+		const double mean = log_price + drift * dt;
+		const double sd = vol_ * sqrt_dt;
+		double survival = 1.0;
+
+		// The normal draw must be below (up-and-out) or above (down-and-out) c.
+		// The conditioned steps of fine and coarse paths use the same inverse
+		// cdf, so its (1e-9) approximation error cancels between the levels:
+		const double c = (log_barrier - mean) / sd;
+		if (barrier_type_ == BarrierType::up_and_out)
+		{
+			if (c < far_from_barrier)
+			{
+				survival = normal_cdf(c);
+				z = approx_inverse_normal_cdf(clamp_prob(normal_cdf(z) * survival));
+				++steps_conditioned;
+			}
+			else if (z >= c)
+			{
+				survival = 0.0;
+			}
+		}
+		else if (barrier_type_ == BarrierType::down_and_out)
+		{
+			if (c > -far_from_barrier)
+			{
+				survival = normal_cdf(-c);
+				z = -approx_inverse_normal_cdf(clamp_prob(normal_cdf(-z) * survival));
+				++steps_conditioned;
+			}
+			else if (z <= c)
+			{
+				survival = 0.0;
+			}
+		}
+
+		log_price = mean + sd * z;
+		return survival;
+	};
+
+	// Discounted payoff of the path through the steps dt, driven by the normals z:
+	auto weighted_payoff = [&](const std::vector<double>& dt, const std::vector<double>& sqrt_dt,
+		const std::vector<double>& z)
+	{
+		double log_price = std::log(spot);
+		double weight = 1.0;
+		for (std::size_t k = 0; k < dt.size() && weight > 0.0; ++k)
+		{
+			weight *= conditional_step(log_price, dt[k], sqrt_dt[k], z[k]);
+		}
+		return weight > 0.0 ? weight * disc_factor * opt_.option_payoff(std::exp(log_price)) : 0.0;
+	};
+
+	auto square_roots = [](const std::vector<double>& v)
+	{
+		std::vector<double> roots(v.size());
+		std::ranges::transform(v, roots.begin(), [](double x) {return std::sqrt(x);});
+		return roots;
+	};
+	const std::vector<double> sqrt_fine_dt = square_roots(fine_dt);
+	const std::vector<double> sqrt_coarse_dt = square_roots(coarse_dt);
+
+	std::vector<double> fine_z(num_dates), coarse_z(coarse_dt.size());
+
+	BlockStats stats;
+	for (std::size_t i = first; i < last; ++i)
+	{
+		Philox4x32 rng{seed, (static_cast<std::uint64_t>(level) << 32) + i};
+		ZigguratNormal{}.fill(rng, fine_z);
+
+		// Each coarse normal is the normalized sum of the Brownian increments
+		// over its fine steps:
+		for (std::size_t j = 0; j < coarse_z.size(); ++j)
+		{
+			double increment = fine_z[2 * j] * sqrt_fine_dt[2 * j];
+			if (2 * j + 1 < fine_z.size()) increment += fine_z[2 * j + 1] * sqrt_fine_dt[2 * j + 1];
+			coarse_z[j] = increment / sqrt_coarse_dt[j];
+		}
+
+		const double fine = weighted_payoff(fine_dt, sqrt_fine_dt, fine_z);
+		const double coarse = level > 0 ? weighted_payoff(coarse_dt, sqrt_coarse_dt, coarse_z) : 0.0;
+		stats.payoffs.add(0.0, fine - coarse);
+		stats.steps_simulated += fine_dt.size() + coarse_dt.size();
+	}
+	stats.steps_conditioned = steps_conditioned;
+
+	return stats;
+}
+
+MCGreeks MCOptionValuation::calc_price_and_greeks(double spot, int num_scenarios,
+	unsigned unif_start_seed)
+{
+	Timer tmr{};
+	tmr.start();
+
+	const std::size_t num_blocks = prepare_greeks_(spot, unif_start_seed)
+		? (num_scenarios + paths_per_block - 1) / paths_per_block : 0;
+
+	GreeksStats estimates;
+	for (std::size_t block = 0; block < num_blocks; ++block)
+	{
+		estimates.merge(simulate_greeks_block_(spot, num_scenarios, unif_start_seed, block));
+	}
+
+	tmr.stop();
+	return make_greeks_(estimates, spot, tmr.milliseconds());
+}
+
+MCGreeks MCOptionValuation::calc_price_and_greeks(double spot, int num_scenarios,
+	unsigned unif_start_seed, ThreadPool& pool)
+{
+	Timer tmr{};
+	tmr.start();
+
+	const std::size_t num_blocks = prepare_greeks_(spot, unif_start_seed)
+		? (num_scenarios + paths_per_block - 1) / paths_per_block : 0;
+
+	std::vector<GreeksStats> block_estimates(num_blocks);
+	pool.parallel_for(num_blocks, [&](std::size_t block)
+		{
+			block_estimates[block] = simulate_greeks_block_(spot, num_scenarios,
+				unif_start_seed, block);
+		});
+
+	GreeksStats estimates;
+	for (const auto& block_est : block_estimates)
+	{
+		estimates.merge(block_est);
+	}
+
+	tmr.stop();
+	return make_greeks_(estimates, spot, tmr.milliseconds());
+}
+
+MCLadder MCOptionValuation::calc_price_ladder(const std::vector<double>& spots,
+	const std::vector<double>& vols, int num_scenarios, unsigned unif_start_seed)
+{
+	return run_ladder_(spots, vols, num_scenarios, unif_start_seed, nullptr);
+}
+
+MCLadder MCOptionValuation::calc_price_ladder(const std::vector<double>& spots,
+	const std::vector<double>& vols, int num_scenarios, unsigned unif_start_seed,
+	ThreadPool& pool)
+{
+	return run_ladder_(spots, vols, num_scenarios, unif_start_seed, &pool);
+}
+
+MCLadder MCOptionValuation::run_ladder_(const std::vector<double>& spots,
+	const std::vector<double>& vols, int num_scenarios, std::uint64_t seed, ThreadPool* pool)
+{
+	if (spots.empty() || vols.empty())
+	{
+		throw std::invalid_argument{"MCOptionValuation::calc_price_ladder: empty grid"};
+	}
+	if (std::ranges::any_of(spots, [](double s) { return s <= 0.0; })
+		|| std::ranges::any_of(vols, [](double v) { return v <= 0.0; }))
+	{
+		throw std::invalid_argument{"MCOptionValuation::calc_price_ladder: "
+			"spots and vols must be positive"};
+	}
+
+	Timer tmr{};
+	tmr.start();
+
+	MCLadder ladder{spots, vols, std::vector<MCResult>(spots.size() * vols.size())};
+	if (opt_.time_to_expiration() <= 0.0)
+	{
+		for (std::size_t i = 0; i < spots.size(); ++i)
+		{
+			const bool barrier_hit = spot_knocked_out_(spots[i]);
+			for (std::size_t j = 0; j < vols.size(); ++j)
+			{
+				ladder.results[i * vols.size() + j] =
+					MCResult{barrier_hit ? 0.0 : opt_.option_payoff(spots[i])};
+			}
+		}
+		tmr.stop();
+		ladder.elapsed = tmr.milliseconds();
+		return ladder;
+	}
+
+	prepare_sampling_(seed);
+	const std::size_t num_blocks = (num_scenarios + paths_per_block - 1) / paths_per_block;
+	std::vector<std::vector<RunningCovariance>> block_stats(num_blocks);
+
+	auto simulate_block = [&](std::size_t block)
+	{
+		block_stats[block] = simulate_ladder_block_(spots, vols, num_scenarios, seed, block);
+	};
+
+	if (pool)
+	{
+		pool->parallel_for(num_blocks, simulate_block);
+	}
+	else
+	{
+		for (std::size_t block = 0; block < num_blocks; ++block) simulate_block(block);
+	}
+
+	std::vector<BlockStats> merged(spots.size() * vols.size());
+	for (const auto& stats : block_stats)		// In block order, for reproducibility
+	{
+		for (std::size_t k = 0; k < merged.size(); ++k)
+		{
+			merged[k].payoffs.merge(stats[k]);
+		}
+	}
+
+	tmr.stop();
+	for (std::size_t i = 0; i < spots.size(); ++i)
+	{
+		for (std::size_t j = 0; j < vols.size(); ++j)
+		{
+			const std::size_t k = i * vols.size() + j;
+			const RunningCovariance& stats = merged[k].payoffs;
+			const std::uint64_t n_paths = antithetic_ ? 2 * stats.count() : stats.count();
+			if (control_)
+			{
+				BlackScholes bsc{control_->strike, spots[i], opt_.time_to_expiration(),
+					control_->type, int_rate_, div_rate_};
+				ladder.results[k] = control_adjusted_result_(merged[k], bsc(vols[j]), n_paths,
+					tmr.milliseconds());
+			}
+			else
+			{
+				ladder.results[k] = MCResult{stats.y().mean(), stats.y().std_error(), n_paths,
+					tmr.milliseconds()};
+			}
+		}
+	}
+
+	ladder.elapsed = tmr.milliseconds();
+	return ladder;
+}
+
+std::vector<RunningCovariance> MCOptionValuation::simulate_ladder_block_(
+	const std::vector<double>& spots, const std::vector<double>& vols,
+	std::size_t num_scenarios, std::uint64_t seed, std::size_t block) const
+{
+	using std::vector;
+
+	const std::size_t first = block * paths_per_block;
+	const std::size_t last = std::min(first + paths_per_block, num_scenarios);
+	const double time_to_exp = opt_.time_to_expiration();
+	const double disc_factor = std::exp(-int_rate_ * time_to_exp);
+	const bool terminal_only = path_dependence_() == PathDependence::terminal_only;
+	const bool up = barrier_type_ == BarrierType::up_and_out;
+	const bool bridge_weights = !terminal_only
+		&& barrier_monitoring_ == BarrierMonitoring::brownian_bridge;
+
+	const std::size_t steps = terminal_only ? 1 : static_cast<std::size_t>(time_steps_);
+	const double dt = time_to_exp / steps;
+
+	// Per vol: the drift and diffusion of log(S) over a step, the log of the
+	// barrier monitored at the steps (which moves with the vol under bgk_shift),
+	// and the scale of the Brownian bridge crossing probability:
+	struct VolConstants
+	{
+		double drift, vol_sqrt_dt, log_barrier, bridge_scale;
+	};
+	vector<VolConstants> vol_consts;
+	vol_consts.reserve(vols.size());
+	for (double vol : vols)
+	{
+		constexpr double beta = 0.5825971579390106;		// As in monitored_barrier_()
+		double barrier = barrier_value_;
+		if (barrier_type_ != BarrierType::none && barrier_monitoring_ == BarrierMonitoring::bgk_shift)
+		{
+			const double shift = std::exp(beta * vol * std::sqrt(time_to_exp / time_steps_));
+			barrier = up ? barrier / shift : barrier * shift;
+		}
+		vol_consts.push_back({(int_rate_ - div_rate_ - 0.5 * vol * vol) * dt, vol * std::sqrt(dt),
+			barrier_type_ == BarrierType::none ? 0.0 : std::log(barrier),
+			-2.0 / (vol * vol * dt)});
+	}
+
+	vector<double> log_spots(spots.size());
+	std::ranges::transform(spots, log_spots.begin(), [](double s) { return std::log(s); });
+
+	const std::size_t grid_size = spots.size() * vols.size();
+	vector<RunningCovariance> stats(grid_size);
+	vector<double> unif(steps), norms(steps), increments(steps);
+	vector<double> log_path(steps + 1);		// log_path[0] = 0, at the spot
+	vector<double> controls(grid_size), payoffs(grid_size);
+	vector<double> anti_controls(grid_size), anti_payoffs(grid_size);
+
+	// The payoff type is dispatched once for the block:
+	opt_.visit_payoff([&](const auto& payoff)
+		{
+			// Discounted control and payoff at each grid point, for the path driven by z:
+			auto grid_payoffs = [&](std::span<const double> z, std::span<double> ctrl,
+				std::span<double> pay)
+			{
+				if (bridge_)
+				{
+					bridge_->transform(z, increments);
+					z = increments;
+				}
+
+				for (std::size_t j = 0; j < vols.size(); ++j)
+				{
+					// log(S(t_k) / S(0)) along the path, with its extremes:
+					const VolConstants& vc = vol_consts[j];
+					double log_return = 0.0, high = 0.0, low = 0.0;
+					for (std::size_t k = 0; k < steps; ++k)
+					{
+						log_return += vc.drift + vc.vol_sqrt_dt * z[k];
+						log_path[k + 1] = log_return;
+						high = std::max(high, log_return);
+						low = std::min(low, log_return);
+					}
+					const double growth = std::exp(log_return);
+
+					for (std::size_t i = 0; i < spots.size(); ++i)
+					{
+						const std::size_t g = i * vols.size() + j;
+						const double terminal_price = spots[i] * growth;
+						ctrl[g] = control_value_(terminal_price, disc_factor);
+
+						// From spots[i], the path is at the barrier when log(S(t_k) / B)
+						// = dist + log_path[k] reaches zero:
+						double weight = 1.0;
+						if (barrier_type_ != BarrierType::none)
+						{
+							const double dist = log_spots[i] - vc.log_barrier;
+							const bool knocked_out = up ? dist + high >= 0.0 : dist + low <= 0.0;
+							if (knocked_out)
+							{
+								weight = 0.0;
+							}
+							else if (bridge_weights)
+							{
+								for (std::size_t k = 0; k < steps; ++k)
+								{
+									weight *= 1.0 - std::exp(vc.bridge_scale
+										* (dist + log_path[k]) * (dist + log_path[k + 1]));
+								}
+							}
+						}
+
+						pay[g] = weight > 0.0 ? weight * disc_factor * payoff.payoff(terminal_price)
+							: 0.0;
+					}
+				}
+			};
+
+			for (std::size_t i = first; i < last; ++i)
+			{
+				draw_normals_(seed, i, unif, norms);
+				grid_payoffs(norms, controls, payoffs);
+
+				if (antithetic_)
+				{
+					for (auto& z : norms) z = -z;
+					grid_payoffs(norms, anti_controls, anti_payoffs);
+					for (std::size_t g = 0; g < grid_size; ++g)
+					{
+						controls[g] = (controls[g] + anti_controls[g]) / 2.0;
+						payoffs[g] = (payoffs[g] + anti_payoffs[g]) / 2.0;
+					}
+				}
+
+				for (std::size_t g = 0; g < grid_size; ++g)
+				{
+					stats[g].add(controls[g], payoffs[g]);
+				}
+			}
+		});
+
+	return stats;
+}
+
+MCResult MCOptionValuation::calc_price_from_scenarios(const ScenarioFile& scenarios)
+{
+	return run_stored_(scenarios, nullptr);
+}
+
+MCResult MCOptionValuation::calc_price_from_scenarios(const ScenarioFile& scenarios,
+	ThreadPool& pool)
+{
+	return run_stored_(scenarios, &pool);
+}
+
+MCResult MCOptionValuation::run_stored_(const ScenarioFile& scenarios, ThreadPool* pool) const
+{
+	const ScenarioHeader& header = scenarios.header();
+	if (header.num_time_steps != static_cast<std::uint64_t>(time_steps_)
+		|| header.time_to_expiration != opt_.time_to_expiration()
+		|| header.volatility != vol_ || header.rf_rate != int_rate_ || header.div_rate != div_rate_)
+	{
+		throw std::invalid_argument{"MCOptionValuation::calc_price_from_scenarios: the scenarios "
+			"were generated with different parameters"};
+	}
+
+	Timer tmr{};
+	tmr.start();
+
+	const double spot = header.spot;
+	if (spot_knocked_out_(spot)) return MCResult{};	// Option is worthless
+	if (opt_.time_to_expiration() <= 0.0) return MCResult{opt_.option_payoff(spot)};
+
+	const std::size_t num_blocks = (header.num_scenarios + paths_per_block - 1) / paths_per_block;
+	std::vector<BlockStats> block_stats(num_blocks);
+
+	auto simulate_block = [&](std::size_t block)
+	{
+		block_stats[block] = header.value_type == ScenarioValueType::float64
+			? simulate_stored_block_<double>(scenarios, block)
+			: simulate_stored_block_<float>(scenarios, block);
+	};
+
+	if (pool)
+	{
+		pool->parallel_for(num_blocks, simulate_block);
+	}
+	else
+	{
+		for (std::size_t block = 0; block < num_blocks; ++block) simulate_block(block);
+	}
+
+	BlockStats merged;
+	for (const auto& stats : block_stats)		// In block order, for reproducibility
+	{
+		merged.merge(stats);
+	}
+
+	tmr.stop();
+	return make_result_(merged, spot, tmr.milliseconds());
+}
+
+template<typename T>
+MCOptionValuation::BlockStats MCOptionValuation::simulate_stored_block_(
+	const ScenarioFile& scenarios, std::size_t block) const
+{
+	const ScenarioHeader& header = scenarios.header();
+	const std::size_t first = block * paths_per_block;
+	const std::size_t count = std::min<std::size_t>(paths_per_block, header.num_scenarios - first);
+	const double disc_factor = std::exp(-int_rate_ * opt_.time_to_expiration());
+
+	// As in add_batch_payoffs_(.), the barrier is checked one time step at a
+	// time, across the scenarios of the block, from contiguous prices:
+	std::vector<unsigned char> barrier_hit(count, 0);
+	std::vector<double> survival(count, 1.0);
+	if (barrier_type_ != BarrierType::none)
+	{
+		const bool up = barrier_type_ == BarrierType::up_and_out;
+		const double barrier = monitored_barrier_();
+		const bool bridge = barrier_monitoring_ == BarrierMonitoring::brownian_bridge;
+		const double scale = -2.0 * time_steps_ / (vol_ * vol_ * opt_.time_to_expiration());
+		std::vector<double> dist(count, std::log(header.spot / barrier_value_));
+
+		for (int step = 1; step <= time_steps_; ++step)
+		{
+			const auto prices = scenarios.prices_at_step<T>(step).subspan(first, count);
+			for (std::size_t i = 0; i < count; ++i)
+			{
+				const double sim_eq = prices[i];
+				barrier_hit[i] |= up ? sim_eq >= barrier : sim_eq <= barrier;
+			}
+
+			if (bridge)
+			{
+				for (std::size_t i = 0; i < count; ++i)
+				{
+					const double next_dist = std::log(prices[i] / barrier_value_);
+					survival[i] *= 1.0 - std::exp(scale * dist[i] * next_dist);
+					dist[i] = next_dist;
+				}
+			}
+		}
+	}
+
+	const auto stored_terminal = scenarios.prices_at_step<T>(time_steps_).subspan(first, count);
+	std::vector<double> terminal_prices(stored_terminal.begin(), stored_terminal.end());
+	std::vector<double> payoffs(count);
+	opt_.option_payoffs(terminal_prices, payoffs);
+
+	BlockStats stats;
+	for (std::size_t i = 0; i < count; ++i)
+	{
+		stats.payoffs.add(control_value_(terminal_prices[i], disc_factor),
+			barrier_hit[i] ? 0.0 : survival[i] * disc_factor * payoffs[i]);
+	}
+
+	return stats;
+}
+
+MCShard MCOptionValuation::calc_price_shard(double spot, int num_scenarios,
+	unsigned unif_start_seed, std::uint64_t first_path, std::uint64_t last_path)
+{
+	return run_shard_(spot, num_scenarios, unif_start_seed, first_path, last_path, nullptr);
+}
+
+MCShard MCOptionValuation::calc_price_shard(double spot, int num_scenarios,
+	unsigned unif_start_seed, std::uint64_t first_path, std::uint64_t last_path, ThreadPool& pool)
+{
+	return run_shard_(spot, num_scenarios, unif_start_seed, first_path, last_path, &pool);
+}
+
+MCShard MCOptionValuation::run_shard_(double spot, int num_scenarios, std::uint64_t seed,
+	std::uint64_t first_path, std::uint64_t last_path, ThreadPool* pool)
+{
+	Timer tmr{};
+	tmr.start();
+
+	const auto [first_block, last_block] =
+		shard_blocks(num_scenarios, paths_per_block, first_path, last_path);
+	const std::size_t num_blocks = last_block - first_block;
+
+	MCShard shard{seed, static_cast<std::uint64_t>(num_scenarios), paths_per_block, first_block,
+		num_blocks, 1, spot, fingerprint_(spot), 0.0, {}, {}, {}};
+	shard.stats.resize(num_blocks);
+	shard.steps_simulated.resize(num_blocks);
+	shard.steps_saved.resize(num_blocks);
+
+	// As in calc_price_with_error(.), nothing is simulated if the option has
+	// already knocked out or expired; merge_shards(.) handles these cases:
+	if (!spot_knocked_out_(spot) && opt_.time_to_expiration() > 0)
+	{
+		prepare_sampling_(seed);
+		run_blocks_in_order(pool, first_block, last_block,
+			[&](std::size_t block) {return simulate_block_(spot, num_scenarios, seed, block);},
+			[&](std::size_t block, BlockStats&& stats)
+			{
+				const std::size_t k = block - first_block;
+				shard.stats[k] = stats.payoffs.state();
+				shard.steps_simulated[k] = stats.steps_simulated;
+				shard.steps_saved[k] = stats.steps_saved;
+				return true;
+			});
+	}
+
+	tmr.stop();
+	shard.elapsed = tmr.milliseconds();
+	return shard;
+}
+
+MCResult MCOptionValuation::merge_shards(std::vector<MCShard> shards) const
+{
+	shards = order_shards(std::move(shards));
+	const double spot = shards.front().spot;
+	if (shards.front().num_instruments != 1 || shards.front().paths_per_block != paths_per_block
+		|| shards.front().fingerprint != fingerprint_(spot))
+	{
+		throw std::invalid_argument{"MCOptionValuation::merge_shards: not shards of this valuation"};
+	}
+
+	if (spot_knocked_out_(spot)) return MCResult{};	// Option is worthless
+	if (opt_.time_to_expiration() <= 0.0) return MCResult{opt_.option_payoff(spot)};
+
+	// The blocks of all shards, merged in block order as by calc_price_with_error(.):
+	BlockStats merged;
+	double elapsed = 0.0;
+	for (const auto& shard : shards)
+	{
+		for (std::size_t k = 0; k < shard.num_blocks; ++k)
+		{
+			merged.merge(BlockStats{RunningCovariance{shard.stats[k]}, shard.steps_simulated[k],
+				shard.steps_saved[k]});
+		}
+		elapsed += shard.elapsed;
+	}
+
+	return make_result_(merged, spot, elapsed);
+}
+
+MCResult MCOptionValuation::calc_price_checkpointed(double spot, int num_scenarios,
+	unsigned unif_start_seed, const std::filesystem::path& checkpoint_file,
+	double checkpoint_interval)
+{
+	return run_checkpointed_(spot, num_scenarios, unif_start_seed, checkpoint_file,
+		checkpoint_interval, nullptr);
+}
+
+MCResult MCOptionValuation::calc_price_checkpointed(double spot, int num_scenarios,
+	unsigned unif_start_seed, const std::filesystem::path& checkpoint_file,
+	double checkpoint_interval, ThreadPool& pool)
+{
+	return run_checkpointed_(spot, num_scenarios, unif_start_seed, checkpoint_file,
+		checkpoint_interval, &pool);
+}
+
+MCResult MCOptionValuation::run_checkpointed_(double spot, int num_scenarios, std::uint64_t seed,
+	const std::filesystem::path& checkpoint_file, double checkpoint_interval, ThreadPool* pool)
+{
+	Timer tmr{};
+	tmr.start();
+
+	if (spot_knocked_out_(spot)) return MCResult{};	// Option is worthless
+	if (opt_.time_to_expiration() <= 0.0) return MCResult{opt_.option_payoff(spot)};
+
+	const std::size_t num_blocks = (num_scenarios + paths_per_block - 1) / paths_per_block;
+	MCCheckpoint checkpoint{seed, static_cast<std::uint64_t>(num_scenarios), paths_per_block,
+		0, 1, spot, fingerprint_(spot), 0.0, 0, 0, {}};
+	checkpoint.stats.resize(1);
+
+	if (auto saved = read_checkpoint_file(checkpoint_file))
+	{
+		if (saved->seed != checkpoint.seed || saved->num_scenarios != checkpoint.num_scenarios
+			|| saved->paths_per_block != checkpoint.paths_per_block
+			|| saved->num_instruments != checkpoint.num_instruments || saved->spot != spot
+			|| saved->fingerprint != checkpoint.fingerprint || saved->next_block > num_blocks)
+		{
+			throw std::invalid_argument{"MCOptionValuation::calc_price_checkpointed: "
+				+ checkpoint_file.string() + " is the checkpoint of another run"};
+		}
+		checkpoint = std::move(*saved);
+	}
+
+	// The merged statistics carry on from the checkpoint, and the blocks are
+	// merged in block order (see run_blocks_in_order(.)), so the result is
+	// that of calc_price_with_error(.) however often the run was stopped:
+	BlockStats discounted_payoffs{RunningCovariance{checkpoint.stats.front()},
+		checkpoint.steps_simulated, checkpoint.steps_saved};
+	const double previous_elapsed = checkpoint.elapsed;
+	double last_save = 0.0;
+
+	prepare_sampling_(seed);
+	run_blocks_in_order(pool, checkpoint.next_block, num_blocks,
+		[&](std::size_t block) {return simulate_block_(spot, num_scenarios, seed, block);},
+		[&](std::size_t block, BlockStats&& stats)
+		{
+			discounted_payoffs.merge(stats);
+			tmr.stop();
+			if (block + 1 == num_blocks || tmr.milliseconds() - last_save >= checkpoint_interval)
+			{
+				checkpoint.next_block = block + 1;
+				checkpoint.elapsed = previous_elapsed + tmr.milliseconds();
+				checkpoint.steps_simulated = discounted_payoffs.steps_simulated;
+				checkpoint.steps_saved = discounted_payoffs.steps_saved;
+				checkpoint.stats.front() = discounted_payoffs.payoffs.state();
+				write_checkpoint_file(checkpoint_file, checkpoint);
+				last_save = tmr.milliseconds();
+			}
+			return true;
+		});
+
+	tmr.stop();
+	return make_result_(discounted_payoffs, spot, previous_elapsed + tmr.milliseconds());
+}
+
+std::uint64_t MCOptionValuation::fingerprint_(double spot) const
+{
+	Fingerprint fp;
+	fp.add(opt_, spot).add(time_steps_).add(vol_).add(int_rate_).add(div_rate_)
+		.add(barrier_type_).add(barrier_value_).add(backend_).add(barrier_monitoring_)
+		.add(sampling_).add(brownian_bridge_).add(antithetic_).add(control_.has_value());
+	if (control_) fp.add(control_->type).add(control_->strike);
+	return fp.value();
+}
+
+void MCOptionValuation::set_path_backend(PathBackend backend)
+{
+	backend_ = backend;
+}
+
+void MCOptionValuation::set_sampling_method(SamplingMethod method, bool brownian_bridge)
+{
+	sampling_ = method;
+	brownian_bridge_ = brownian_bridge;
+}
+
+void MCOptionValuation::set_barrier_monitoring(BarrierMonitoring monitoring)
+{
+	barrier_monitoring_ = monitoring;
+}
+
+void MCOptionValuation::set_antithetic(bool antithetic)
+{
+	antithetic_ = antithetic;
+}
+
+void MCOptionValuation::set_control_variate(PayoffType vanilla_type, double vanilla_strike)
+{
+	control_ = ControlVariate{vanilla_type, vanilla_strike};
+}
+
+void MCOptionValuation::clear_control_variate()
+{
+	control_.reset();
+}
+
+void MCOptionValuation::prepare_sampling_(std::uint64_t seed)
+{
+	if (sampling_ != SamplingMethod::sobol)
+	{
+		sobol_.reset();
+		bridge_.reset();
+		return;
+	}
+
+	// A terminal-only payoff needs a single dimension:
+	const std::size_t dims = (path_dependence_() == PathDependence::terminal_only) ? 1
+		: static_cast<std::size_t>(time_steps_);
+
+	// The direction numbers only depend on the dimension, so are kept between
+	// valuations; the digital shift is redrawn from each seed:
+	if (!sobol_ || sobol_->dimensions() != dims) sobol_.emplace(dims);
+	sobol_->randomize(seed);
+
+	if (brownian_bridge_ && dims > 1)
+	{
+		if (!bridge_ || bridge_->num_steps() != dims) bridge_.emplace(dims);
+	}
+	else
+	{
+		bridge_.reset();
+	}
+}
+
+MCOptionValuation::BlockStats MCOptionValuation::simulate_block_(double spot, std::size_t num_scenarios,
+	std::uint64_t seed, std::size_t block) const
+{
+	using std::vector;
+
+	const std::size_t first = block * paths_per_block;
+	const std::size_t last = std::min(first + paths_per_block, num_scenarios);
+	const double disc_factor = std::exp(-int_rate_ * opt_.time_to_expiration());
+	const bool terminal_only = path_dependence_() == PathDependence::terminal_only;
+	const auto [lower_barrier, upper_barrier] = knock_out_levels_();
+
+	BlockStats stats;
+
+	if (sampling_ == SamplingMethod::sobol || antithetic_)
+	{
+		// The normals are drawn explicitly -- from Sobol point i (prepared by
+		// prepare_sampling_(.)) through the inverse cdf, or from the stream of
+		// scenario i -- so that the antithetic path can be driven by -z:
+		EquityPriceGenerator epg{spot, time_steps_, opt_.time_to_expiration(), vol_,
+			int_rate_, div_rate_};
+		const std::size_t dims = terminal_only ? 1 : static_cast<std::size_t>(time_steps_);
+		vector<double> unif(dims), norms(dims), increments(dims), scenario(time_steps_ + 1);
+
+		// Discounted control and payoff of the path driven by z:
+		auto control_and_payoff = [&](std::span<const double> z) -> std::array<double, 2>
+		{
+			if (terminal_only)
+			{
+				++stats.steps_simulated;
+				const double terminal_price = epg.terminal_price_from_normal(z[0]);
+				return {control_value_(terminal_price, disc_factor),
+					disc_factor * opt_.option_payoff(terminal_price)};
+			}
+
+			if (bridge_)
+			{
+				bridge_->transform(z, increments);
+				z = increments;
+			}
+			const int steps = epg.path_from_normals(z, scenario, lower_barrier, upper_barrier);
+			stats.steps_simulated += steps;
+			if (steps < time_steps_)		// Knocked out
+			{
+				stats.steps_saved += time_steps_ - steps;
+				return {0.0, 0.0};
+			}
+			return {control_value_(scenario.back(), disc_factor),
+				discounted_payoff_(scenario, disc_factor)};
+		};
+
+		for (std::size_t i = first; i < last; ++i)
+		{
+			draw_normals_(seed, i, unif, norms);
+
+			auto [control, payoff] = control_and_payoff(norms);
+			if (antithetic_)
+			{
+				for (auto& z : norms) z = -z;
+				auto [control_anti, payoff_anti] = control_and_payoff(norms);
+				control = (control + control_anti) / 2.0;
+				payoff = (payoff + payoff_anti) / 2.0;
+			}
+			stats.payoffs.add(control, payoff);
+		}
+	}
+	else if (terminal_only)
+	{
+		// No barrier, and the payoff only needs S(T): sample it
+		// directly from its lognormal law in a single draw:
+		EquityPriceGenerator epg{spot, time_steps_, opt_.time_to_expiration(), vol_,
+			int_rate_, div_rate_};
+		for (std::size_t i = first; i < last; ++i)
+		{
+			Philox4x32 rng{seed, i};
+			const double terminal_price = epg.terminal_price(rng);
+			stats.payoffs.add(control_value_(terminal_price, disc_factor),
+				disc_factor * opt_.option_payoff(terminal_price));
+		}
+		stats.steps_simulated += last - first;
+	}
+	else if (backend_ == PathBackend::batch)
+	{
+		// Blocks of `lanes` scenarios are stepped together, each block
+		// drawing from the stream of its first scenario.  The lanes run
+		// to expiration, whether or not they knock out:
+		constexpr std::size_t lanes = BatchEquityPriceGenerator::lanes;
+		BatchEquityPriceGenerator bepg{spot, time_steps_, opt_.time_to_expiration(), vol_,
+			int_rate_, div_rate_};
+		vector<double> lane_block((time_steps_ + 1) * lanes);
+		for (std::size_t i = first; i < last; i += lanes)
+		{
+			Philox4x32 rng{seed, i};
+			bepg(rng, lane_block);
+			add_batch_payoffs_(lane_block, std::min(lanes, last - i), disc_factor, stats.payoffs);
+		}
+		stats.steps_simulated += (last - first) * time_steps_;
+	}
+	else
+	{
+		EquityPriceGenerator epg{spot, time_steps_, opt_.time_to_expiration(), vol_,
+			int_rate_, div_rate_};
+		vector<double> scenario(time_steps_ + 1);		// Reused by each scenario in the block
+		for (std::size_t i = first; i < last; ++i)
+		{
+			// The path is abandoned as soon as it knocks out:
+			Philox4x32 rng{seed, i};
+			const int steps = epg(rng, scenario, lower_barrier, upper_barrier);
+			stats.steps_simulated += steps;
+			if (steps < time_steps_)
+			{
+				stats.steps_saved += time_steps_ - steps;
+				stats.payoffs.add(0.0, 0.0);
+				continue;
+			}
+
+			stats.payoffs.add(control_value_(scenario.back(), disc_factor),
+				discounted_payoff_(scenario, disc_factor));
+		}
+	}
+
+	return stats;
+}
+
+MCResult MCOptionValuation::make_result_(const BlockStats& block_stats, double spot,
+	double elapsed) const
+{
+	const RunningCovariance& stats = block_stats.payoffs;
+	const std::uint64_t n_paths = antithetic_ ? 2 * stats.count() : stats.count();
+	if (!control_ || stats.count() < 2)
+	{
+		return MCResult{stats.y().mean(), stats.y().std_error(), n_paths, elapsed,
+			block_stats.steps_simulated, block_stats.steps_saved};
+	}
+
+	BlackScholes bsc{control_->strike, spot, opt_.time_to_expiration(), control_->type,
+		int_rate_, div_rate_};
+	return control_adjusted_result_(block_stats, bsc(vol_), n_paths, elapsed);
+}
+
+MCResult MCOptionValuation::control_adjusted_result_(const BlockStats& block_stats,
+	double control_price, std::uint64_t n_paths, double elapsed)
+{
+	const RunningCovariance& stats = block_stats.payoffs;
+	if (stats.count() < 2)
+	{
+		return MCResult{stats.y().mean(), stats.y().std_error(), n_paths, elapsed,
+			block_stats.steps_simulated, block_stats.steps_saved};
+	}
+
+	// beta minimizes the variance of Y - beta * X, leaving var(Y) - beta * cov(X, Y):
+	const double var_x = stats.x().variance();
+	const double beta = var_x > 0.0 ? stats.covariance() / var_x : 0.0;
+	const double residual_var = std::max(stats.y().variance() - beta * stats.covariance(), 0.0);
+
+	return MCResult{stats.y().mean() - beta * (stats.x().mean() - control_price),
+		std::sqrt(residual_var / stats.count()), n_paths, elapsed,
+		block_stats.steps_simulated, block_stats.steps_saved};
+}
+
+void MCOptionValuation::BlockStats::merge(const BlockStats& other)
+{
+	payoffs.merge(other.payoffs);
+	steps_simulated += other.steps_simulated;
+	steps_saved += other.steps_saved;
+	steps_conditioned += other.steps_conditioned;
+}
+
+bool MCOptionValuation::spot_knocked_out_(double spot) const
+{
+	return (barrier_type_ == BarrierType::up_and_out && spot >= barrier_value_) ||
+		(barrier_type_ == BarrierType::down_and_out && spot <= barrier_value_);
+}
+
+std::array<double, 2> MCOptionValuation::knock_out_levels_() const
+{
+	constexpr double inf = std::numeric_limits<double>::infinity();
+
+	// A control variate needs S(T) from every path, so paths then run to expiration:
+	if (barrier_type_ == BarrierType::none || control_) return {-inf, inf};
+
+	const double barrier = monitored_barrier_();
+	return barrier_type_ == BarrierType::up_and_out ? std::array{-inf, barrier}
+		: std::array{barrier, inf};
+}
+
+double MCOptionValuation::control_value_(double terminal_price, double disc_factor) const
+{
+	if (!control_) return 0.0;
+
+	const double phi = static_cast<int>(control_->type);	// +1: call, -1: put
+	return disc_factor * std::max(phi * (terminal_price - control_->strike), 0.0);
+}
+
+PathDependence MCOptionValuation::path_dependence_() const
+{
+	// A knock-out barrier has to be monitored along the path,
+	// whatever the payoff at expiration:
+	return barrier_type_ == BarrierType::none ? opt_.path_dependence()
+		: PathDependence::path_dependent;
+}
+
+double MCOptionValuation::discounted_payoff_(std::span<const double> scenario,
+	double disc_factor) const
+{
+	const double barrier = monitored_barrier_();
+	bool barrier_hit = false;
+
+	switch (barrier_type_)
+	{
+		case BarrierType::none: break;
+
+		case BarrierType::up_and_out:
+			barrier_hit = std::ranges::any_of(scenario,
+				[barrier](double sim_eq) {return sim_eq >= barrier;});
+			break;
+
+		case BarrierType::down_and_out:
+			barrier_hit = std::ranges::any_of(scenario,
+				[barrier](double sim_eq) {return sim_eq <= barrier;});
+			break;
+	}
+
+	if (barrier_hit) return 0.0;
+
+	const double survival = (barrier_type_ != BarrierType::none
+		&& barrier_monitoring_ == BarrierMonitoring::brownian_bridge)
+		? bridge_survival_probability_(scenario) : 1.0;
+
+	return survival * disc_factor * opt_.option_payoff(scenario.back());
+}
+
+void MCOptionValuation::add_batch_payoffs_(std::span<const double> block, std::size_t num_used,
+	double disc_factor, RunningCovariance& stats) const
+{
+	constexpr std::size_t lanes = BatchEquityPriceGenerator::lanes;
+	std::array<bool, lanes> barrier_hit{};
+	std::array<double, lanes> survival;
+	survival.fill(1.0);
+
+	// The barrier is checked one time step (row) at a time, across all lanes:
+	if (barrier_type_ != BarrierType::none)
+	{
+		const bool up = barrier_type_ == BarrierType::up_and_out;
+		const double barrier = monitored_barrier_();
+		for (std::size_t row = 0; row < block.size(); row += lanes)
+		{
+			for (std::size_t k = 0; k < lanes; ++k)
+			{
+				const double sim_eq = block[row + k];
+				barrier_hit[k] = barrier_hit[k] || (up ? sim_eq >= barrier : sim_eq <= barrier);
+			}
+		}
+
+		if (barrier_monitoring_ == BarrierMonitoring::brownian_bridge)
+		{
+			const double scale = -2.0 * time_steps_ / (vol_ * vol_ * opt_.time_to_expiration());
+			std::array<double, lanes> dist;
+			for (std::size_t k = 0; k < lanes; ++k)
+			{
+				dist[k] = std::log(block[k] / barrier_value_);
+			}
+			for (std::size_t row = lanes; row < block.size(); row += lanes)
+			{
+				for (std::size_t k = 0; k < lanes; ++k)
+				{
+					const double next_dist = std::log(block[row + k] / barrier_value_);
+					survival[k] *= 1.0 - std::exp(scale * dist[k] * next_dist);
+					dist[k] = next_dist;
+				}
+			}
+		}
+	}
+
+	const auto terminal_prices = block.last(lanes);
+	std::array<double, lanes> payoffs;
+	opt_.option_payoffs(terminal_prices, payoffs);
+	for (std::size_t k = 0; k < num_used; ++k)
+	{
+		stats.add(control_value_(terminal_prices[k], disc_factor), barrier_hit[k] ? 0.0
+			: survival[k] * disc_factor * payoffs[k]);
+	}
+}
+
+double MCOptionValuation::monitored_barrier_() const
+{
+	if (barrier_monitoring_ != BarrierMonitoring::bgk_shift) return barrier_value_;
+
+	// Broadie, Glasserman & Kou (1997): monitoring at the time steps against the
+	// barrier moved towards the spot by a factor exp(beta * vol * sqrt(dt)),
+	// with beta = -zeta(1/2) / sqrt(2 pi), approximates continuous monitoring:
+	constexpr double beta = 0.5825971579390106;
+	const double shift = std::exp(beta * vol_ * std::sqrt(opt_.time_to_expiration() / time_steps_));
+	return barrier_type_ == BarrierType::up_and_out ? barrier_value_ / shift
+		: barrier_value_ * shift;
+}
+
+double MCOptionValuation::bridge_survival_probability_(std::span<const double> scenario) const
+{
+	// Between consecutive prices S_i and S_(i+1), both on the live side of the
+	// barrier B, log(S) is a Brownian bridge, which touches log(B) with
+	// probability exp(-2 log(S_i/B) log(S_(i+1)/B) / (vol^2 dt)):
+	const double scale = -2.0 * time_steps_ / (vol_ * vol_ * opt_.time_to_expiration());
+
+	double survival = 1.0;
+	double dist = std::log(scenario.front() / barrier_value_);
+	for (std::size_t i = 1; i < scenario.size(); ++i)
+	{
+		const double next_dist = std::log(scenario[i] / barrier_value_);
+		survival *= 1.0 - std::exp(scale * dist * next_dist);
+		dist = next_dist;
+	}
+
+	return survival;
+}
+
+void MCOptionValuation::draw_normals_(std::uint64_t seed, std::size_t i, std::span<double> unif,
+	std::span<double> norms) const
+{
+	if (sampling_ == SamplingMethod::sobol)
+	{
+		sobol_->point(i, unif);
+		std::ranges::transform(unif, norms.begin(), inverse_normal_cdf);
+	}
+	else
+	{
+		Philox4x32 rng{seed, i};
+		ZigguratNormal{}.fill(rng, norms);
+	}
+}
+
+bool MCOptionValuation::prepare_greeks_(double spot, std::uint64_t seed)
+{
+	if (!opt_.continuous_payoff())
+	{
+		throw std::invalid_argument{"MCOptionValuation::calc_price_and_greeks: "
+			"pathwise Greeks need a continuous payoff"};
+	}
+
+	// The Greeks of an option that is already knocked out, or at expiration,
+	// are taken as zero (MCGreeks{} apart from the price):
+	if (spot_knocked_out_(spot) || opt_.time_to_expiration() <= 0.0) return false;
+
+	prepare_sampling_(seed);
+	return true;
+}
+
+void MCOptionValuation::GreeksStats::merge(const GreeksStats& other)
+{
+	price.merge(other.price);
+	delta.merge(other.delta);
+	gamma.merge(other.gamma);
+	vega.merge(other.vega);
+}
+
+MCOptionValuation::GreeksStats MCOptionValuation::simulate_greeks_block_(double spot,
+	std::size_t num_scenarios, std::uint64_t seed, std::size_t block) const
+{
+	using std::vector;
+
+	const std::size_t first = block * paths_per_block;
+	const std::size_t last = std::min(first + paths_per_block, num_scenarios);
+	const bool terminal_only = path_dependence_() == PathDependence::terminal_only;
+
+	EquityPriceGenerator epg{spot, time_steps_, opt_.time_to_expiration(), vol_,
+		int_rate_, div_rate_};
+	const std::size_t dims = terminal_only ? 1 : static_cast<std::size_t>(time_steps_);
+	vector<double> unif(dims), norms(dims), increments(dims), scenario(time_steps_ + 1);
+
+	auto path_estimates = [&](std::span<const double> z)
+	{
+		if (bridge_)
+		{
+			bridge_->transform(z, increments);
+			z = increments;
+		}
+		return terminal_only ? terminal_greeks_(spot, z[0], epg)
+			: path_greeks_(spot, z, epg, scenario);
+	};
+
+	GreeksStats stats;
+	for (std::size_t i = first; i < last; ++i)
+	{
+		draw_normals_(seed, i, unif, norms);
+
+		auto est = path_estimates(norms);
+		if (antithetic_)
+		{
+			for (auto& z : norms) z = -z;
+			const auto est_anti = path_estimates(norms);
+			for (std::size_t k = 0; k < est.size(); ++k)
+			{
+				est[k] = (est[k] + est_anti[k]) / 2.0;
+			}
+		}
+
+		stats.price.add(est[0]);
+		stats.delta.add(est[1]);
+		stats.gamma.add(est[2]);
+		stats.vega.add(est[3]);
+	}
+
+	return stats;
+}
+
+std::array<double, 4> MCOptionValuation::terminal_greeks_(double spot, double z,
+	const EquityPriceGenerator& epg) const
+{
+	// S(T) = spot * exp((r - q - vol^2/2) T + vol sqrt(T) z), so that
+	// dS(T)/dspot = S(T)/spot, and dS(T)/dvol = S(T) (sqrt(T) z - vol T):
+	const double t = opt_.time_to_expiration();
+	const double sqrt_t = std::sqrt(t);
+	const double disc_factor = std::exp(-int_rate_ * t);
+
+	const double terminal_price = epg.terminal_price_from_normal(z);
+	const double payoff = disc_factor * opt_.option_payoff(terminal_price);
+	const double payoff_deriv = disc_factor * opt_.option_payoff_derivative(terminal_price);
+
+	// Pathwise delta and vega; likelihood-ratio gamma, from the second derivative
+	// of the lognormal density of S(T) with respect to spot:
+	const double delta = payoff_deriv * terminal_price / spot;
+	const double vega = payoff_deriv * terminal_price * (sqrt_t * z - vol_ * t);
+	const double gamma = payoff * (z * z - 1.0 - z * vol_ * sqrt_t)
+		/ (spot * spot * vol_ * vol_ * t);
+
+	return {payoff, delta, gamma, vega};
+}
+
+std::array<double, 4> MCOptionValuation::path_greeks_(double spot, std::span<const double> z,
+	const EquityPriceGenerator& epg, std::span<double> scenario) const
+{
+	const double t = opt_.time_to_expiration();
+	const double dt = t / time_steps_;
+	const double disc_factor = std::exp(-int_rate_ * t);
+	const double vol_sq_dt = vol_ * vol_ * dt;
+
+	epg.path_from_normals(z, scenario);
+	const double terminal_price = scenario.back();
+
+	// The knock-out indicator is replaced by the Brownian-bridge probability of
+	// survival, prod_i (1 - p_i) with p_i = exp(-2 a_i a_(i+1) / (vol^2 dt)) and
+	// a_i = log(S_i / B), which is smooth in the path and falls continuously to
+	// zero at the barrier, so can be differentiated along the path.  Each
+	// S_i is proportional to spot, and dS_i/dvol = S_i g_i, with
+	// g_i = (log(S_i / spot) - (r - q + vol^2/2) t_i) / vol:
+	double survival = 1.0, dlog_surv_dspot = 0.0, dlog_surv_dvol = 0.0;
+	double later_survival = 1.0;		// Of the steps after the first
+	double first_cross = 0.0;			// p_0, of the first step
+	double first_log_dist = 0.0;		// a_1
+	if (barrier_type_ != BarrierType::none)
+	{
+		const double barrier = greeks_barrier_();
+		const bool up = barrier_type_ == BarrierType::up_and_out;
+		const bool hit = std::ranges::any_of(scenario,
+			[up, barrier](double sim_eq) {return up ? sim_eq >= barrier : sim_eq <= barrier;});
+		if (hit) return {};
+
+		const double mu = int_rate_ - div_rate_ + vol_ * vol_ / 2.0;
+		double a = std::log(spot / barrier), g = 0.0;
+		for (int i = 1; i <= time_steps_; ++i)
+		{
+			const double a_next = std::log(scenario[i] / barrier);
+			const double g_next = (std::log(scenario[i] / spot) - mu * i * dt) / vol_;
+
+			const double p = std::exp(-2.0 * a * a_next / vol_sq_dt);
+			const double odds = p / (1.0 - p);
+			survival *= 1.0 - p;
+			if (i == 1)
+			{
+				first_cross = p;
+				first_log_dist = a_next;
+			}
+			else
+			{
+				later_survival *= 1.0 - p;
+			}
+			dlog_surv_dspot += odds * 2.0 * (a + a_next) / (vol_sq_dt * spot);
+			dlog_surv_dvol -= odds * (4.0 * a * a_next / (vol_sq_dt * vol_)
+				- 2.0 * (g * a_next + a * g_next) / vol_sq_dt);
+
+			a = a_next;
+			g = g_next;
+		}
+	}
+
+	const double g_terminal = (std::log(terminal_price / spot)
+		- (int_rate_ - div_rate_ + vol_ * vol_ / 2.0) * t) / vol_;
+	const double payoff = disc_factor * opt_.option_payoff(terminal_price);
+	const double payoff_deriv = disc_factor * opt_.option_payoff_derivative(terminal_price);
+
+	const double value = survival * payoff;
+	const double delta = survival * (payoff_deriv * terminal_price / spot + payoff * dlog_surv_dspot);
+	const double vega = survival * (payoff_deriv * terminal_price * g_terminal
+		+ payoff * dlog_surv_dvol);
+
+	// Given S_1, the rest of the path does not depend on spot, which enters
+	// the smoothed value f through the density of S_1, and directly through
+	// the first bridge factor 1 - p_0, with p_0 = exp(-2 a_0 a_1 / (vol^2 dt))
+	// and a_0 = log(spot / B).  So gamma = E[f w_2 + 2 f' w_1 + f''], with the
+	// likelihood-ratio weights w_1 and w_2 of the lognormal density of S_1 (of
+	// variance growing as 1/dt, making gamma noisier on fine time grids), and
+	// f' and f'' the derivatives of f in spot with S_1 held fixed:
+	const double sqrt_dt = std::sqrt(dt);
+	const double w_1 = z[0] / (spot * vol_ * sqrt_dt);
+	const double w_2 = (z[0] * z[0] - 1.0 - z[0] * vol_ * sqrt_dt) / (spot * spot * vol_sq_dt);
+
+	const double c_1 = 2.0 * first_log_dist / vol_sq_dt;			// -d log(p_0)/d a_0
+	const double later_value = later_survival * payoff;
+	const double df_dspot = later_value * c_1 * first_cross / spot;
+	const double d2f_dspot2 = -later_value * c_1 * first_cross * (c_1 + 1.0) / (spot * spot);
+	const double gamma = value * w_2 + 2.0 * df_dspot * w_1 + d2f_dspot2;
+
+	return {value, delta, gamma, vega};
+}
+
+double MCOptionValuation::greeks_barrier_() const
+{
+	if (barrier_monitoring_ != BarrierMonitoring::discrete) return barrier_value_;
+
+	// A barrier monitored at the time steps is priced as a continuous barrier
+	// moved away from the spot by exp(beta * vol * sqrt(dt)) (Broadie,
+	// Glasserman & Kou, the reverse of BarrierMonitoring::bgk_shift):
+	constexpr double beta = 0.5825971579390106;
+	const double shift = std::exp(beta * vol_ * std::sqrt(opt_.time_to_expiration() / time_steps_));
+	return barrier_type_ == BarrierType::up_and_out ? barrier_value_ * shift
+		: barrier_value_ / shift;
+}
+
+MCGreeks MCOptionValuation::make_greeks_(const GreeksStats& stats, double spot,
+	double elapsed) const
+{
+	if (stats.price.count() == 0)
+	{
+		// Knocked out (worthless), or at expiration:
+		return MCGreeks{MCResult{spot_knocked_out_(spot) ? 0.0 : opt_.option_payoff(spot)}};
+	}
+
+	const std::uint64_t n_paths = antithetic_ ? 2 * stats.price.count() : stats.price.count();
+	return MCGreeks{MCResult{stats.price.mean(), stats.price.std_error(), n_paths, elapsed},
+		stats.delta.mean(), stats.delta.std_error(), stats.gamma.mean(), stats.gamma.std_error(),
+		stats.vega.mean(), stats.vega.std_error()};
+}
@@ -6,6 +6,28 @@
 #pragma once
 
 #include "OptionInfo.h"
+#include "ThreadPool.h"
+#include "RunningStats.h"
+#include "SobolSequence.h"
+#include "BrownianBridge.h"
+#include "BlackScholes.h"
+#include "PathModels.h"
+#include "PathPayoffs.h"
+#include "MCShard.h"
+#include "MCCheckpoint.h"
+#include "NormalSamplers.h"
+#include "Philox.h"
+#include "Timer.h"
+
+#include <span>
+#include <filesystem>
+#include <optional>
+#include <array>
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstddef>
 
 enum class BarrierType
 {
@@ -14,6 +36,100 @@ enum class BarrierType
 	down_and_out	
 };
 
+// How a knock-out barrier is monitored along a path of time_steps steps:
+enum class BarrierMonitoring
+{
+	discrete,			// At the time steps only
+	brownian_bridge,	// Continuously: each surviving payoff is weighted by the
+						// probability that the path did not cross between steps
+	bgk_shift			// Continuously, approximately: at the time steps, against
+						// a barrier shifted towards the spot (Broadie-Glasserman-Kou)
+};
+
+// How equity price scenarios are generated for path-dependent valuations:
+enum class PathBackend
+{
+	scalar,		// EquityPriceGenerator, one scenario at a time
+	batch		// BatchEquityPriceGenerator, blocks of scenarios stepped together (SIMD)
+};
+
+// How the normal variates driving each scenario are drawn:
+enum class SamplingMethod
+{
+	pseudo_random,	// Philox4x32 stream per scenario
+	sobol			// Randomized (digitally shifted) Sobol points, quasi-Monte Carlo
+};
+
+// Why a Monte Carlo valuation stopped:
+enum class StopReason
+{
+	num_scenarios,		// The requested (or maximum) number of scenarios was simulated
+	target_error,		// The standard error met its target
+	time_budget			// The time budget was used up
+};
+
+// Result of a Monte Carlo valuation: the estimated price, together with the
+// standard error of the estimate (so that price +/- 1.96 * std_error is an
+// approximate 95% confidence interval), the number of paths, and the
+// elapsed wall-clock time in milliseconds.
+struct MCResult
+{
+	double price{0.0};
+	double std_error{0.0};
+	std::uint64_t n_paths{0};
+	double elapsed{0.0};
+
+	// Time steps simulated over all paths, and the steps that were skipped
+	// because a path knocked out before expiration:
+	std::uint64_t steps_simulated{0};
+	std::uint64_t steps_saved{0};
+
+	StopReason stop_reason{StopReason::num_scenarios};
+};
+
+// Stopping rule for MCOptionValuation::calc_price_adaptive(.).  A target of
+// zero is not used; the valuation stops at whichever target is met first.
+// The error targets are only tested once min_scenarios paths are in, as the
+// standard error of a small sample can be far too small (all zero, for an
+// option deep out of the money), and a zero standard error never meets the
+// relative target:
+struct StoppingRule
+{
+	double target_abs_error{0.0};		// std_error <= target_abs_error
+	double target_rel_error{0.0};		// 0 < std_error <= target_rel_error * |price|
+	double time_budget{0.0};			// Elapsed milliseconds >= time_budget
+	int max_scenarios{10'000'000};		// Upper limit in any case
+	int min_scenarios{32'768};			// Before the error targets are tested
+};
+
+// Price and sensitivities to the spot (delta, gamma) and the volatility
+// (vega) from a single set of paths, each with its standard error:
+struct MCGreeks
+{
+	MCResult price;
+	double delta{0.0}, delta_std_error{0.0};
+	double gamma{0.0}, gamma_std_error{0.0};
+	double vega{0.0}, vega_std_error{0.0};
+};
+
+// Prices on a grid of spots and vols, from MCOptionValuation::calc_price_ladder(.).
+// result(i, j) is the price at spots[i] and vols[j]:
+struct MCLadder
+{
+	std::vector<double> spots;
+	std::vector<double> vols;
+	std::vector<MCResult> results;		// Spot-major: results[i * vols.size() + j]
+	double elapsed{0.0};				// Milliseconds, for the whole grid
+
+	const MCResult& result(std::size_t i, std::size_t j) const
+	{
+		return results[i * vols.size() + j];
+	}
+};
+
+class EquityPriceGenerator;
+class ScenarioFile;
+
 class MCOptionValuation
 {
 public:
@@ -37,14 +153,575 @@ public:
 	// calc_price(.) is generalized further to accommodate up/down-and-out barriers:
 	double calc_price(double spot, int num_scenarios, unsigned unif_start_seed);
 
+	// Same as calc_price(.), but the discounted payoffs are accumulated as a
+	// running mean and variance, and the standard error is returned with the price:
+	MCResult calc_price_with_error(double spot, int num_scenarios, unsigned unif_start_seed);
+
 	// calc_price_par(.) accommodates up/down-and-out barriers and
 	// will generate equity price scenarios in parallel:
 	double calc_price_par(double spot, int num_scenarios, unsigned unif_start_seed);
 
+	// This overload runs blocks of scenarios as tasks on a reusable ThreadPool,
+	// each block accumulating its own partial statistics, in place of one
+	// std::async per scenario.  As each scenario has its own counter-based
+	// random stream, the result is bit-identical to calc_price(.) for any
+	// number of threads:
+	double calc_price_par(double spot, int num_scenarios, unsigned unif_start_seed,
+		ThreadPool& pool);
+	MCResult calc_price_with_error(double spot, int num_scenarios, unsigned unif_start_seed,
+		ThreadPool& pool);
+
+	// Runs blocks of scenarios until the stopping rule is met, rather than for a
+	// fixed number of scenarios, and reports which limit stopped it in
+	// MCResult::stop_reason: easy valuations stop early, hard ones get more paths.
+	// The error targets are checked after each block, in block order, so with a
+	// ThreadPool the result is the same as the serial one (some blocks of the last
+	// batch may be discarded).  The time budget is checked after each block
+	// (serial) or batch of blocks (ThreadPool), so may be overrun by that much:
+	MCResult calc_price_adaptive(double spot, const StoppingRule& rule, unsigned unif_start_seed);
+	MCResult calc_price_adaptive(double spot, const StoppingRule& rule, unsigned unif_start_seed,
+		ThreadPool& pool);
+
+	// Multilevel Monte Carlo (Giles), for barrier options with many time steps.
+	// Level L monitors the barrier on the full grid of time_steps dates, and
+	// each level below it on every other date of the level above (and at
+	// expiration), down to expiration alone at level 0.  The price is the level 0
+	// estimate plus the mean differences P_l - P_(l-1) between a path on the
+	// dates of level l and a coarse path on those of level l - 1, driven by the
+	// same Brownian motion.  The sum is unbiased for the price on the full grid,
+	// and most paths are simulated on the coarse levels, where they are cheap:
+	// samples are allocated across the levels from their observed variances
+	// and costs until the standard error is within the target.
+	//
+	// A knock-out is a discontinuous function of the path, which would keep the
+	// variance of P_l - P_(l-1) high, so each step near the barrier is instead
+	// drawn conditional on surviving the barrier at its end, and the path
+	// weighted by the probability of that (one-step survival, Glasserman and
+	// Staum).  Such a step costs several plain ones, which the allocation
+	// takes into account.  Level l, scenario i draws from Philox4x32{seed,
+	// 2^32 l + i}, in blocks merged in order, so a ThreadPool does not change
+	// the result.
+	//
+	// The barrier is monitored at the time steps (BarrierMonitoring::discrete);
+	// the sampling method and variance reduction settings do not apply.
+	// MCResult::n_paths counts the samples over all levels, and steps_simulated
+	// the steps of their fine and coarse paths:
+	MCResult calc_price_mlmc(double spot, double target_std_error, unsigned unif_start_seed);
+	MCResult calc_price_mlmc(double spot, double target_std_error, unsigned unif_start_seed,
+		ThreadPool& pool);
+
+	// Price, delta, gamma, and vega from one set of paths, rather than repricing
+	// with bumped inputs: delta and vega are pathwise (differentiating each
+	// discounted payoff along its path, using Payoff::payoff_derivative(.)),
+	// and gamma is a likelihood-ratio estimate (the payoff weighted by the
+	// derivative of the path density), which does not need a second derivative
+	// of the payoff.  The sampling method and antithetic setting apply; the
+	// control variate and the path backend do not.  A discontinuous payoff
+	// (Payoff::is_continuous(), eg DigitalPayoff) has a pathwise delta and
+	// vega of zero almost surely, however wrong, so throws std::invalid_argument.
+	//
+	// The knock-out of a barrier option is not differentiable, so it is smoothed:
+	// paths are weighted by their Brownian-bridge survival probability, as
+	// with BarrierMonitoring::brownian_bridge.  Under discrete monitoring, the
+	// barrier is then moved away from the spot by the Broadie-Glasserman-Kou
+	// shift, and the returned price is that of the smoothed payoff.
+	MCGreeks calc_price_and_greeks(double spot, int num_scenarios, unsigned unif_start_seed);
+	MCGreeks calc_price_and_greeks(double spot, int num_scenarios, unsigned unif_start_seed,
+		ThreadPool& pool);
+
+	// Risk ladder: prices at every point of a grid of spots and vols from the
+	// same scenarios (common random numbers), rather than from independent
+	// valuations, so that the differences between neighbouring points are not
+	// swamped by Monte Carlo noise.  The normals of each scenario are drawn
+	// once.  The log-price recurrence is then re-run for each vol, and each spot
+	// shifts the log path, so that a spot costs O(1) per scenario and vol: a
+	// knock-out compares the running extremes of the log path with log(B/S).
+	// BarrierMonitoring::brownian_bridge is the exception, as its weight
+	// depends on every step.
+	//
+	// The sampling method, antithetic, barrier monitoring, and control variate
+	// settings apply as in calc_price_with_error(.), but not the path backend.
+	// At the constructor's vol, the same random numbers are used as by
+	// calc_price_with_error(.).  Each MCResult has the elapsed time of the
+	// whole grid, and no step counts:
+	MCLadder calc_price_ladder(const std::vector<double>& spots, const std::vector<double>& vols,
+		int num_scenarios, unsigned unif_start_seed);
+	MCLadder calc_price_ladder(const std::vector<double>& spots, const std::vector<double>& vols,
+		int num_scenarios, unsigned unif_start_seed, ThreadPool& pool);
+
+	// Prices against the paths in a memory-mapped scenario file (see
+	// ScenarioStore.h), rather than simulating them, at the spot of the file.
+	// The file must have been generated with the time steps, time to
+	// expiration, vol, and rates of this valuation (std::invalid_argument
+	// otherwise).  The prices are read in place, in blocks of paths_per_block
+	// scenarios, one time step at a time.  The barrier monitoring and control
+	// variate settings apply; the sampling method, antithetic, and path backend
+	// settings do not, and the step counts are not reported.  For a
+	// path-dependent valuation, a float64 file gives the price of
+	// calc_price_with_error(.) with the seed of the file:
+	MCResult calc_price_from_scenarios(const ScenarioFile& scenarios);
+	MCResult calc_price_from_scenarios(const ScenarioFile& scenarios, ThreadPool& pool);
+
+	// Runs the scenarios [first_path, last_path) of calc_price_with_error(spot,
+	// num_scenarios, unif_start_seed), as one shard of a run split across
+	// processes or machines (see MCShard.h).  The range must be of whole blocks
+	// of paths_per_block scenarios (std::invalid_argument otherwise), as given
+	// by shard_paths(.).  merge_shards(.) then combines the shards of a run,
+	// from valuations with the same parameters and settings, into the result of
+	// calc_price_with_error(.), bit for bit; its elapsed time is the sum of
+	// those of the shards.  Each shard holds a fingerprint of the parameters
+	// and settings, and shards of another valuation throw std::invalid_argument:
+	MCShard calc_price_shard(double spot, int num_scenarios, unsigned unif_start_seed,
+		std::uint64_t first_path, std::uint64_t last_path);
+	MCShard calc_price_shard(double spot, int num_scenarios, unsigned unif_start_seed,
+		std::uint64_t first_path, std::uint64_t last_path, ThreadPool& pool);
+	MCResult merge_shards(std::vector<MCShard> shards) const;
+
+	// calc_price_with_error(.), saving its progress to checkpoint_file (see
+	// MCCheckpoint.h) when it completes, and after any block once
+	// checkpoint_interval milliseconds have passed since the last save.  If
+	// checkpoint_file holds the progress of an interrupted run with the same
+	// spot, number of scenarios, seed, and fingerprint of the valuation's
+	// parameters and settings, the run resumes from it, and the result is that
+	// of an uninterrupted run, bit for bit; only the elapsed time, summed over
+	// the attempts, differs.  A checkpoint of another run throws
+	// std::invalid_argument, and that of the same run, finished, gives its
+	// result at once, so the file is to be removed before starting a new run:
+	MCResult calc_price_checkpointed(double spot, int num_scenarios, unsigned unif_start_seed,
+		const std::filesystem::path& checkpoint_file, double checkpoint_interval = 60'000.0);
+	MCResult calc_price_checkpointed(double spot, int num_scenarios, unsigned unif_start_seed,
+		const std::filesystem::path& checkpoint_file, double checkpoint_interval,
+		ThreadPool& pool);
+
+	// Prices with paths from a stochastic or local volatility model (see
+	// PathModels.h) in place of constant-vol GBM, so the vol passed to the
+	// constructor is not used.  These are member templates, rather than
+	// MCOptionValuation being a class template, so that the GBM valuations
+	// above are unchanged; either way, Model::step(.) is statically dispatched
+	// and inlined into the stepping loop.  Scenario i draws from the stream
+	// Philox4x32{seed, i}, in the same blocks as calc_price_with_error(.), and a
+	// knocked-out path is abandoned at once.  The barrier is monitored at the
+	// time steps only, as the continuous corrections assume a constant vol, and
+	// the sampling method, variance reduction, and path backend settings do not
+	// apply:
+	template<PathModel Model>
+	MCResult calc_price_with_model(double spot, int num_scenarios, unsigned unif_start_seed,
+		const Model& model);
+	template<PathModel Model>
+	MCResult calc_price_with_model(double spot, int num_scenarios, unsigned unif_start_seed,
+		const Model& model, ThreadPool& pool);
+
+	// Prices a path-functional payoff (see PathPayoffs.h), such as an Asian or
+	// lookback option or a range accrual, in place of the payoff of `opt`
+	// (whose time to expiration is still used).  Each path updates the payoff's
+	// State at every time step as it is generated, so no scenario is stored.
+	// If the payoff has a control variate (eg, the geometric Asian for an
+	// arithmetic Asian), it is applied, with beta estimated from the same
+	// scenarios as for set_control_variate(.).  Scenario i draws from the
+	// stream Philox4x32{seed, i}, in the same blocks as calc_price_with_error(.).
+	// The barrier is monitored at the time steps, and a knocked-out path is
+	// abandoned at once, unless the control needs the rest of it.  The sampling
+	// method, variance reduction, and path backend settings do not apply:
+	template<PathFunctional Functional>
+	MCResult calc_price_path_functional(double spot, int num_scenarios,
+		unsigned unif_start_seed, const Functional& payoff);
+	template<PathFunctional Functional>
+	MCResult calc_price_path_functional(double spot, int num_scenarios,
+		unsigned unif_start_seed, const Functional& payoff, ThreadPool& pool);
+
+	// Selects the scenario generator used by calc_price(.), calc_price_with_error(.),
+	// and the ThreadPool version of calc_price_par(.) (default: PathBackend::scalar).
+	// PathBackend::batch is faster only in builds that vectorize it (see
+	// BatchEquityPriceGenerator.h):
+	void set_path_backend(PathBackend backend);
+
+	// Selects how the barrier is monitored (default: BarrierMonitoring::discrete).
+	// The two continuous modes price a continuously monitored barrier from a
+	// coarse time grid (eg, 12-50 steps) rather than thousands of steps:
+	void set_barrier_monitoring(BarrierMonitoring monitoring);
+
+	// Selects pseudo-random or quasi-random (Sobol) sampling (default:
+	// SamplingMethod::pseudo_random).  In Sobol mode, scenario i uses point i
+	// of a Sobol sequence in time_steps dimensions, randomized by a digital
+	// shift drawn from the seed, and mapped to normals by the inverse cdf; with
+	// brownian_bridge set, these normals build the path by Brownian-bridge
+	// construction rather than step by step.  Sobol paths are generated one at
+	// a time, so the path backend is ignored in this mode.
+	//
+	// The built-in direction numbers are Joe & Kuo's up to 1024 dimensions (time
+	// steps); beyond that, the further dimensions are not optimized, and lose
+	// much of the benefit of low discrepancy (see SobolSequence.h).
+	//
+	// The std_error reported in Sobol mode treats the points as independent,
+	// and so overstates the (much smaller) quasi-Monte Carlo error; an honest
+	// error estimate comes from the spread of prices over several seeds.
+	void set_sampling_method(SamplingMethod method, bool brownian_bridge = true);
+
+	// Variance reduction, for the same valuation functions.  With antithetic
+	// sampling, each scenario is a pair of paths driven by the normals z and -z,
+	// and contributes the average of their discounted payoffs (MCResult::n_paths
+	// counts both paths).  The batch backend draws its normals internally, so
+	// antithetic pairs are generated one path at a time:
+	void set_antithetic(bool antithetic);
+
+	// Uses the discounted payoff X of a European vanilla option on S(T), whose
+	// Black-Scholes price is known, as a control variate for the discounted
+	// payoff Y: the price becomes mean(Y) - beta * (mean(X) - BS price), with
+	// beta = cov(X, Y) / var(X) estimated from the same scenarios.  The gain is
+	// largest when Y and X are highly correlated, eg a barrier option and the
+	// vanilla with the same strike:
+	void set_control_variate(PayoffType vanilla_type, double vanilla_strike);
+	void clear_control_variate();
+
 private:
 	OptionInfo opt_;
 	int time_steps_;
 	double vol_, int_rate_, div_rate_;	
 	BarrierType barrier_type_;
 	double barrier_value_;
-};
\ No newline at end of file
+	PathBackend backend_{PathBackend::scalar};
+	BarrierMonitoring barrier_monitoring_{BarrierMonitoring::discrete};
+	SamplingMethod sampling_{SamplingMethod::pseudo_random};
+	bool brownian_bridge_{true};
+	bool antithetic_{false};
+
+	struct ControlVariate
+	{
+		PayoffType type;
+		double strike;
+	};
+	std::optional<ControlVariate> control_;
+
+	// Built (or re-randomized) by prepare_sampling_(.) before a valuation, and
+	// then only read by the blocks:
+	std::optional<SobolSequence> sobol_;
+	std::optional<BrownianBridge> bridge_;
+	void prepare_sampling_(std::uint64_t seed);
+
+	// Scenarios are simulated in fixed blocks of paths_per_block (a multiple of
+	// BatchEquityPriceGenerator::lanes), scenario i drawing from the stream
+	// Philox4x32{seed, i}.  The statistics of each block are merged in block
+	// order, so a result does not depend on how the blocks were scheduled.
+	// The block statistics are of pairs (discounted control, discounted payoff),
+	// the control being zero when not in use, together with step counts:
+	static constexpr std::size_t paths_per_block = 4096;
+
+	struct BlockStats
+	{
+		RunningCovariance payoffs;
+		std::uint64_t steps_simulated{0};
+		std::uint64_t steps_saved{0};
+		std::uint64_t steps_conditioned{0};		// MLMC only: one-step survival steps
+
+		void merge(const BlockStats& other);
+	};
+
+	BlockStats simulate_block_(double spot, std::size_t num_scenarios, std::uint64_t seed,
+		std::size_t block) const;
+
+	// Path-independent payoffs without a barrier only need the terminal price,
+	// which calc_price(.) and its variants then sample in a single draw:
+	PathDependence path_dependence_() const;
+
+	// Price and standard error from the merged statistics of all blocks,
+	// adjusted by the control variate if there is one:
+	MCResult make_result_(const BlockStats& block_stats, double spot, double elapsed) const;
+
+	// The same, from statistics of (discounted control, discounted payoff)
+	// pairs, and the discounted price of the control:
+	static MCResult control_adjusted_result_(const BlockStats& block_stats,
+		double control_price, std::uint64_t n_paths, double elapsed);
+
+	// Normals driving scenario i: the Sobol point through the inverse cdf,
+	// or draws from the stream Philox4x32{seed, i}:
+	void draw_normals_(std::uint64_t seed, std::size_t i, std::span<double> unif,
+		std::span<double> norms) const;
+
+	// Greeks: per block statistics of the estimates of each path, and their
+	// {price, delta, gamma, vega} per path (see calc_price_and_greeks(.)):
+	struct GreeksStats
+	{
+		RunningStats price, delta, gamma, vega;
+
+		void merge(const GreeksStats& other);
+	};
+
+	bool prepare_greeks_(double spot, std::uint64_t seed);		// false: nothing to simulate
+	GreeksStats simulate_greeks_block_(double spot, std::size_t num_scenarios,
+		std::uint64_t seed, std::size_t block) const;
+	std::array<double, 4> terminal_greeks_(double spot, double z,
+		const EquityPriceGenerator& epg) const;
+	std::array<double, 4> path_greeks_(double spot, std::span<const double> z,
+		const EquityPriceGenerator& epg, std::span<double> scenario) const;
+	double greeks_barrier_() const;
+	MCGreeks make_greeks_(const GreeksStats& stats, double spot, double elapsed) const;
+
+	// Common implementation of calc_price_adaptive(.), serial if pool is null:
+	MCResult run_adaptive_(double spot, const StoppingRule& rule, std::uint64_t seed,
+		ThreadPool* pool);
+
+	// Common implementation of calc_price_ladder(.), serial if pool is null, and
+	// the statistics of (discounted control, discounted payoff) at each point of
+	// the grid over the scenarios in a block:
+	MCLadder run_ladder_(const std::vector<double>& spots, const std::vector<double>& vols,
+		int num_scenarios, std::uint64_t seed, ThreadPool* pool);
+	std::vector<RunningCovariance> simulate_ladder_block_(const std::vector<double>& spots,
+		const std::vector<double>& vols, std::size_t num_scenarios, std::uint64_t seed,
+		std::size_t block) const;
+
+	// Common implementation of calc_price_from_scenarios(.), serial if pool is
+	// null, and the statistics of a block of stored scenarios, whose prices are
+	// of type T (double or float):
+	MCResult run_stored_(const ScenarioFile& scenarios, ThreadPool* pool) const;
+	template<typename T>
+	BlockStats simulate_stored_block_(const ScenarioFile& scenarios, std::size_t block) const;
+
+	// Fingerprint of the parameters and settings that a result depends on,
+	// kept in shard and checkpoint files (see Fingerprint.h):
+	std::uint64_t fingerprint_(double spot) const;
+
+	// Common implementation of calc_price_shard(.), serial if pool is null:
+	MCShard run_shard_(double spot, int num_scenarios, std::uint64_t seed,
+		std::uint64_t first_path, std::uint64_t last_path, ThreadPool* pool);
+
+	// Common implementation of calc_price_checkpointed(.), serial if pool is null:
+	MCResult run_checkpointed_(double spot, int num_scenarios, std::uint64_t seed,
+		const std::filesystem::path& checkpoint_file, double checkpoint_interval,
+		ThreadPool* pool);
+
+	// Common implementation of calc_price_mlmc(.), serial if pool is null:
+	MCResult run_mlmc_(double spot, double target_std_error, std::uint64_t seed,
+		ThreadPool* pool) const;
+
+	// Statistics of the differences P_l - P_(l-1) (P_0 at level 0) over
+	// scenarios first, ..., last - 1 of the level monitored every stride steps:
+	BlockStats simulate_mlmc_block_(double spot, int level, int stride, std::uint64_t seed,
+		std::size_t first, std::size_t last) const;
+
+	// Pilot samples per level, from which MLMC estimates the level variances
+	// and costs:
+	static constexpr std::size_t initial_mlmc_samples = 1024;
+
+	// The cost of an MLMC step drawn conditional on survival, in plain steps
+	// (it takes two normal cdfs and an inverse cdf, rather than a Ziggurat
+	// normal alone):
+	static constexpr double conditioned_step_cost = 4.0;
+
+	// Whether the option has already knocked out at spot, so is worthless:
+	bool spot_knocked_out_(double spot) const;
+
+	// Price levels {lower, upper} at which a path is abandoned while being
+	// stepped (infinite when every path has to run to expiration):
+	std::array<double, 2> knock_out_levels_() const;
+
+	// Discounted payoff of the control variate, or zero without one:
+	double control_value_(double terminal_price, double disc_factor) const;
+
+	// Discounted payoff of a single scenario, or zero if the barrier was hit.
+	// With BarrierMonitoring::brownian_bridge, the payoff is weighted by the
+	// probability of no crossing between the steps:
+	double discounted_payoff_(std::span<const double> scenario, double disc_factor) const;
+
+	// Barrier level checked at the time steps (shifted for BarrierMonitoring::bgk_shift):
+	double monitored_barrier_() const;
+
+	// Probability that a Brownian bridge through the prices in the scenario
+	// does not cross the barrier between any two of them:
+	double bridge_survival_probability_(std::span<const double> scenario) const;
+
+	// Adds the discounted payoffs of the first num_used scenarios in a block
+	// generated by BatchEquityPriceGenerator:
+	void add_batch_payoffs_(std::span<const double> block, std::size_t num_used,
+		double disc_factor, RunningCovariance& stats) const;
+
+	// Common implementation of calc_price_with_model(.), serial if pool is null:
+	template<PathModel Model>
+	MCResult run_model_(double spot, int num_scenarios, std::uint64_t seed, const Model& model,
+		ThreadPool* pool) const;
+
+	// Common implementation of calc_price_path_functional(.), serial if pool is null:
+	template<PathFunctional Functional>
+	MCResult run_path_functional_(double spot, int num_scenarios, std::uint64_t seed,
+		const Functional& payoff, ThreadPool* pool) const;
+};
+
+template<PathModel Model>
+MCResult MCOptionValuation::calc_price_with_model(double spot, int num_scenarios,
+	unsigned unif_start_seed, const Model& model)
+{
+	return run_model_(spot, num_scenarios, unif_start_seed, model, nullptr);
+}
+
+template<PathModel Model>
+MCResult MCOptionValuation::calc_price_with_model(double spot, int num_scenarios,
+	unsigned unif_start_seed, const Model& model, ThreadPool& pool)
+{
+	return run_model_(spot, num_scenarios, unif_start_seed, model, &pool);
+}
+
+template<PathModel Model>
+MCResult MCOptionValuation::run_model_(double spot, int num_scenarios, std::uint64_t seed,
+	const Model& model, ThreadPool* pool) const
+{
+	Timer tmr{};
+	tmr.start();
+
+	if (spot_knocked_out_(spot)) return MCResult{};	// Option is worthless
+	if (opt_.time_to_expiration() <= 0) return MCResult{opt_.option_payoff(spot)};
+
+	const double time_to_exp = opt_.time_to_expiration();
+	const double dt = time_to_exp / time_steps_;
+	const double carry = int_rate_ - div_rate_;
+	const double disc_factor = std::exp(-int_rate_ * time_to_exp);
+
+	const bool up = barrier_type_ == BarrierType::up_and_out;
+	const bool down = barrier_type_ == BarrierType::down_and_out;
+
+	const std::size_t num_blocks = (num_scenarios + paths_per_block - 1) / paths_per_block;
+
+	auto simulate_block = [&](std::size_t block)
+	{
+		BlockStats stats;
+		const std::size_t first = block * paths_per_block;
+		const std::size_t last = std::min(first + paths_per_block,
+			static_cast<std::size_t>(num_scenarios));
+
+		for (std::size_t i = first; i < last; ++i)
+		{
+			Philox4x32 rng{seed, i};
+			typename Model::State state = model.initial_state(spot);
+			double equity_price = spot;
+			bool knocked_out = false;
+
+			int step = 1;
+			for (; step <= time_steps_; ++step)
+			{
+				equity_price = model.step(state, (step - 1) * dt, dt, carry, rng);
+				if ((up && equity_price >= barrier_value_) || (down && equity_price <= barrier_value_))
+				{
+					knocked_out = true;
+					break;
+				}
+			}
+
+			const int steps = std::min(step, time_steps_);
+			stats.steps_simulated += steps;
+			stats.steps_saved += time_steps_ - steps;
+			stats.payoffs.add(0.0, knocked_out ? 0.0 : disc_factor * opt_.option_payoff(equity_price));
+		}
+		return stats;
+	};
+
+	// Merged in block order, for reproducibility (see run_blocks_in_order(.)):
+	BlockStats merged;
+	run_blocks_in_order(pool, 0, num_blocks, simulate_block,
+		[&merged](std::size_t, BlockStats&& stats) {merged.merge(stats); return true;});
+
+	tmr.stop();
+	const RunningStats& payoffs = merged.payoffs.y();
+	return MCResult{payoffs.mean(), payoffs.std_error(), payoffs.count(), tmr.milliseconds(),
+		merged.steps_simulated, merged.steps_saved};
+}
+
+template<PathFunctional Functional>
+MCResult MCOptionValuation::calc_price_path_functional(double spot, int num_scenarios,
+	unsigned unif_start_seed, const Functional& payoff)
+{
+	return run_path_functional_(spot, num_scenarios, unif_start_seed, payoff, nullptr);
+}
+
+template<PathFunctional Functional>
+MCResult MCOptionValuation::calc_price_path_functional(double spot, int num_scenarios,
+	unsigned unif_start_seed, const Functional& payoff, ThreadPool& pool)
+{
+	return run_path_functional_(spot, num_scenarios, unif_start_seed, payoff, &pool);
+}
+
+template<PathFunctional Functional>
+MCResult MCOptionValuation::run_path_functional_(double spot, int num_scenarios,
+	std::uint64_t seed, const Functional& payoff, ThreadPool* pool) const
+{
+	constexpr bool with_control = PathFunctionalWithControl<Functional>;
+
+	Timer tmr{};
+	tmr.start();
+
+	if (spot_knocked_out_(spot)) return MCResult{};	// Option is worthless
+	if (opt_.time_to_expiration() <= 0)
+	{
+		// Every time step is now, at the spot:
+		typename Functional::State state = payoff.initial_state(spot);
+		payoff.update(state, spot);
+		return MCResult{static_cast<double>(payoff.payoff(state))};
+	}
+
+	const double time_to_exp = opt_.time_to_expiration();
+	const double dt = time_to_exp / time_steps_;
+	const double drift = (int_rate_ - div_rate_ - 0.5 * vol_ * vol_) * dt;
+	const double vol_sqrt_dt = vol_ * std::sqrt(dt);
+	const double log_spot = std::log(spot);
+	const double disc_factor = std::exp(-int_rate_ * time_to_exp);
+
+	const bool up = barrier_type_ == BarrierType::up_and_out;
+	const bool down = barrier_type_ == BarrierType::down_and_out;
+
+	const std::size_t num_blocks = (num_scenarios + paths_per_block - 1) / paths_per_block;
+
+	auto simulate_block = [&](std::size_t block)
+	{
+		BlockStats stats;
+		const std::size_t first = block * paths_per_block;
+		const std::size_t last = std::min(first + paths_per_block,
+			static_cast<std::size_t>(num_scenarios));
+		ZigguratNormal zn{};
+
+		for (std::size_t i = first; i < last; ++i)
+		{
+			Philox4x32 rng{seed, i};
+			typename Functional::State state = payoff.initial_state(spot);
+			double log_price = log_spot;
+			bool knocked_out = false;
+
+			int step = 1;
+			for (; step <= time_steps_; ++step)
+			{
+				log_price += drift + vol_sqrt_dt * zn(rng);
+				const double equity_price = std::exp(log_price);
+				if (!knocked_out && ((up && equity_price >= barrier_value_)
+					|| (down && equity_price <= barrier_value_)))
+				{
+					knocked_out = true;
+					if constexpr (!with_control) break;
+				}
+				payoff.update(state, equity_price);
+			}
+
+			const int steps = std::min(step, time_steps_);
+			stats.steps_simulated += steps;
+			stats.steps_saved += time_steps_ - steps;
+
+			double control = 0.0;
+			if constexpr (with_control) control = disc_factor * payoff.control(state);
+			stats.payoffs.add(control, knocked_out ? 0.0 : disc_factor * payoff.payoff(state));
+		}
+		return stats;
+	};
+
+	// Merged in block order, for reproducibility (see run_blocks_in_order(.)):
+	BlockStats merged;
+	run_blocks_in_order(pool, 0, num_blocks, simulate_block,
+		[&merged](std::size_t, BlockStats&& stats) {merged.merge(stats); return true;});
+
+	tmr.stop();
+	if constexpr (with_control)
+	{
+		return control_adjusted_result_(merged, payoff.control_price(spot, time_to_exp,
+			time_steps_, vol_, int_rate_, div_rate_), merged.payoffs.count(), tmr.milliseconds());
+	}
+	else
+	{
+		const RunningStats& payoffs = merged.payoffs.y();
+		return MCResult{payoffs.mean(), payoffs.std_error(), payoffs.count(), tmr.milliseconds(),
+			merged.steps_simulated, merged.steps_saved};
+	}
+}
@@ -0,0 +1,426 @@
+/*
+ * This file is licensed under the Mozilla Public License, v. 2.0.
+ * You can obtain a copy of the license at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "MCPortfolioValuation.h"
+#include "Philox.h"
+#include "NormalSamplers.h"
+#include "Timer.h"
+#include "Fingerprint.h"
+
+#include <utility>		// std::move
+#include <cmath>
+#include <algorithm>
+#include <stdexcept>
+
+MCPortfolioValuation::MCPortfolioValuation(std::vector<OptionInfo>&& opts,
+	std::vector<BarrierSpec> barriers, int time_steps, double vol, double int_rate,
+	double div_rate) : opts_{std::move(opts)}, vol_{vol}, int_rate_{int_rate}, div_rate_{div_rate}
+{
+	if (!barriers.empty() && barriers.size() != opts_.size())
+	{
+		throw std::invalid_argument{"MCPortfolioValuation: need one barrier spec per option"};
+	}
+	if (time_steps < 1)
+	{
+		throw std::invalid_argument{"MCPortfolioValuation: time_steps must be positive"};
+	}
+
+	// Time grid: each expiration, and the time_steps equal steps up to its
+	// expiration of each barrier option (points closer together than a tiny
+	// tolerance are merged):
+	auto barrier_of = [&barriers](std::size_t k)
+		{return barriers.empty() ? BarrierSpec{} : barriers[k];};
+
+	double horizon = 0.0;
+	for (const auto& opt : opts_)
+	{
+		horizon = std::max(horizon, opt.time_to_expiration());
+	}
+
+	times_.push_back(0.0);
+	for (std::size_t k = 0; k < opts_.size(); ++k)
+	{
+		const double t = std::max(opts_[k].time_to_expiration(), 0.0);
+		times_.push_back(t);
+		if (barrier_of(k).type != BarrierType::none && t > 0.0)
+		{
+			for (int i = 1; i < time_steps; ++i)
+			{
+				times_.push_back(t * i / time_steps);
+			}
+		}
+	}
+
+	const double tol = 1e-12 * std::max(horizon, 1.0);
+	std::ranges::sort(times_);
+	auto [last, end] = std::ranges::unique(times_, [tol](double a, double b) {return b - a < tol;});
+	times_.erase(last, end);
+
+	for (std::size_t i = 1; i < times_.size(); ++i)
+	{
+		const double dt = times_[i] - times_[i - 1];
+		step_drift_.push_back((int_rate_ - div_rate_ - vol_ * vol_ / 2.0) * dt);
+		step_vol_.push_back(vol_ * std::sqrt(dt));
+	}
+
+	auto grid_point = [this, tol](double t)
+		{return static_cast<std::size_t>(std::ranges::lower_bound(times_, t - tol) - times_.begin());};
+
+	// Grid point of each expiration, and the distinct barriers, each with the
+	// grid points of its monitoring dates:
+	for (std::size_t k = 0; k < opts_.size(); ++k)
+	{
+		const double t = std::max(opts_[k].time_to_expiration(), 0.0);
+		expiry_step_.push_back(grid_point(t));
+
+		const BarrierSpec barrier = barrier_of(k);
+		if (barrier.type == BarrierType::none)
+		{
+			barrier_idx_.push_back(-1);
+			continue;
+		}
+
+		auto same = std::ranges::find_if(distinct_barriers_,
+			[&barrier, t, tol](const MonitoredBarrier& b) {return b.spec.type == barrier.type
+				&& b.spec.value == barrier.value && std::abs(b.expiry - t) < tol;});
+		barrier_idx_.push_back(static_cast<int>(same - distinct_barriers_.begin()));
+		if (same == distinct_barriers_.end())
+		{
+			MonitoredBarrier monitored{barrier, t, std::vector<bool>(times_.size(), false)};
+			for (int i = 1; i <= time_steps && t > 0.0; ++i)
+			{
+				monitored.monitored[grid_point(t * i / time_steps)] = true;
+			}
+			distinct_barriers_.push_back(std::move(monitored));
+		}
+	}
+}
+
+std::size_t MCPortfolioValuation::size() const
+{
+	return opts_.size();
+}
+
+void MCPortfolioValuation::set_barrier_monitoring(BarrierMonitoring monitoring)
+{
+	if (monitoring == BarrierMonitoring::bgk_shift)
+	{
+		throw std::invalid_argument{"MCPortfolioValuation: BGK shift needs equal time steps"};
+	}
+	barrier_monitoring_ = monitoring;
+}
+
+std::vector<MCResult> MCPortfolioValuation::calc_prices(double spot, int num_scenarios,
+	unsigned unif_start_seed)
+{
+	Timer tmr{};
+	tmr.start();
+
+	const std::size_t num_blocks = (num_scenarios + paths_per_block - 1) / paths_per_block;
+	std::vector<RunningStats> stats(opts_.size());
+	for (std::size_t block = 0; block < num_blocks; ++block)
+	{
+		auto block_stats = simulate_block_(spot, num_scenarios, unif_start_seed, block);
+		for (std::size_t k = 0; k < stats.size(); ++k)
+		{
+			stats[k].merge(block_stats[k]);
+		}
+	}
+
+	tmr.stop();
+	return make_results_(stats, num_scenarios, tmr.milliseconds());
+}
+
+std::vector<MCResult> MCPortfolioValuation::calc_prices(double spot, int num_scenarios,
+	unsigned unif_start_seed, ThreadPool& pool)
+{
+	Timer tmr{};
+	tmr.start();
+
+	const std::size_t num_blocks = (num_scenarios + paths_per_block - 1) / paths_per_block;
+	std::vector<std::vector<RunningStats>> block_stats(num_blocks);
+	pool.parallel_for(num_blocks, [&](std::size_t block)
+		{
+			block_stats[block] = simulate_block_(spot, num_scenarios, unif_start_seed, block);
+		});
+
+	// Merged in block order, as in the serial version:
+	std::vector<RunningStats> stats(opts_.size());
+	for (const auto& bs : block_stats)
+	{
+		for (std::size_t k = 0; k < stats.size(); ++k)
+		{
+			stats[k].merge(bs[k]);
+		}
+	}
+
+	tmr.stop();
+	return make_results_(stats, num_scenarios, tmr.milliseconds());
+}
+
+MCShard MCPortfolioValuation::calc_prices_shard(double spot, int num_scenarios,
+	unsigned unif_start_seed, std::uint64_t first_path, std::uint64_t last_path)
+{
+	return run_shard_(spot, num_scenarios, unif_start_seed, first_path, last_path, nullptr);
+}
+
+MCShard MCPortfolioValuation::calc_prices_shard(double spot, int num_scenarios,
+	unsigned unif_start_seed, std::uint64_t first_path, std::uint64_t last_path, ThreadPool& pool)
+{
+	return run_shard_(spot, num_scenarios, unif_start_seed, first_path, last_path, &pool);
+}
+
+MCShard MCPortfolioValuation::run_shard_(double spot, int num_scenarios, std::uint64_t seed,
+	std::uint64_t first_path, std::uint64_t last_path, ThreadPool* pool) const
+{
+	Timer tmr{};
+	tmr.start();
+
+	const auto [first_block, last_block] =
+		shard_blocks(num_scenarios, paths_per_block, first_path, last_path);
+	const std::size_t num_blocks = last_block - first_block;
+	const std::size_t num_opts = opts_.size();
+
+	// Each instrument's statistics are those of its payoffs alone (the y of a
+	// RunningCovariance), with no control:
+	MCShard shard{seed, static_cast<std::uint64_t>(num_scenarios), paths_per_block, first_block,
+		num_blocks, num_opts, spot, fingerprint_(spot), 0.0, {}, {}, {}};
+	shard.stats.resize(num_blocks * num_opts);
+	shard.steps_simulated.resize(num_blocks);
+	shard.steps_saved.resize(num_blocks);
+
+	run_blocks_in_order(pool, first_block, last_block,
+		[&](std::size_t block) {return simulate_block_(spot, num_scenarios, seed, block);},
+		[&](std::size_t block, std::vector<RunningStats>&& block_stats)
+		{
+			const std::size_t k = block - first_block;
+			for (std::size_t j = 0; j < num_opts; ++j)
+			{
+				shard.stats[k * num_opts + j].y = block_stats[j].state();
+			}
+			return true;
+		});
+
+	tmr.stop();
+	shard.elapsed = tmr.milliseconds();
+	return shard;
+}
+
+std::vector<MCResult> MCPortfolioValuation::merge_shards(std::vector<MCShard> shards) const
+{
+	shards = order_shards(std::move(shards));
+	if (shards.front().num_instruments != opts_.size()
+		|| shards.front().paths_per_block != paths_per_block
+		|| shards.front().fingerprint != fingerprint_(shards.front().spot))
+	{
+		throw std::invalid_argument{"MCPortfolioValuation::merge_shards: not shards of this book"};
+	}
+
+	// Merged in block order, as in calc_prices(.):
+	std::vector<RunningStats> stats(opts_.size());
+	double elapsed = 0.0;
+	for (const auto& shard : shards)
+	{
+		for (std::size_t k = 0; k < shard.num_blocks; ++k)
+		{
+			for (std::size_t j = 0; j < stats.size(); ++j)
+			{
+				stats[j].merge(RunningStats{shard.stats[k * stats.size() + j].y});
+			}
+		}
+		elapsed += shard.elapsed;
+	}
+
+	return make_results_(stats, shards.front().num_scenarios, elapsed);
+}
+
+std::uint64_t MCPortfolioValuation::fingerprint_(double spot) const
+{
+	Fingerprint fp;
+	for (std::size_t k = 0; k < opts_.size(); ++k)
+	{
+		const BarrierSpec barrier = barrier_idx_[k] < 0 ? BarrierSpec{}
+			: distinct_barriers_[barrier_idx_[k]].spec;
+		fp.add(opts_[k], spot).add(barrier.type).add(barrier.value);
+	}
+	for (const auto& b : distinct_barriers_)
+	{
+		for (bool monitored : b.monitored) fp.add(monitored);
+	}
+	for (double t : times_) fp.add(t);
+	fp.add(vol_).add(int_rate_).add(div_rate_).add(barrier_monitoring_);
+	return fp.value();
+}
+
+std::vector<MCResult> MCPortfolioValuation::calc_prices_checkpointed(double spot,
+	int num_scenarios, unsigned unif_start_seed, const std::filesystem::path& checkpoint_file,
+	double checkpoint_interval)
+{
+	return run_checkpointed_(spot, num_scenarios, unif_start_seed, checkpoint_file,
+		checkpoint_interval, nullptr);
+}
+
+std::vector<MCResult> MCPortfolioValuation::calc_prices_checkpointed(double spot,
+	int num_scenarios, unsigned unif_start_seed, const std::filesystem::path& checkpoint_file,
+	double checkpoint_interval, ThreadPool& pool)
+{
+	return run_checkpointed_(spot, num_scenarios, unif_start_seed, checkpoint_file,
+		checkpoint_interval, &pool);
+}
+
+std::vector<MCResult> MCPortfolioValuation::run_checkpointed_(double spot, int num_scenarios,
+	std::uint64_t seed, const std::filesystem::path& checkpoint_file, double checkpoint_interval,
+	ThreadPool* pool) const
+{
+	Timer tmr{};
+	tmr.start();
+
+	const std::size_t num_blocks = (num_scenarios + paths_per_block - 1) / paths_per_block;
+	MCCheckpoint checkpoint{seed, static_cast<std::uint64_t>(num_scenarios), paths_per_block,
+		0, opts_.size(), spot, fingerprint_(spot), 0.0, 0, 0, {}};
+	checkpoint.stats.resize(opts_.size());
+
+	if (auto saved = read_checkpoint_file(checkpoint_file))
+	{
+		if (saved->seed != checkpoint.seed || saved->num_scenarios != checkpoint.num_scenarios
+			|| saved->paths_per_block != checkpoint.paths_per_block
+			|| saved->num_instruments != checkpoint.num_instruments || saved->spot != spot
+			|| saved->fingerprint != checkpoint.fingerprint || saved->next_block > num_blocks)
+		{
+			throw std::invalid_argument{"MCPortfolioValuation::calc_prices_checkpointed: "
+				+ checkpoint_file.string() + " is the checkpoint of another run"};
+		}
+		checkpoint = std::move(*saved);
+	}
+
+	// Carried on from the checkpoint, and merged in block order, as in calc_prices(.):
+	std::vector<RunningStats> stats;
+	for (const auto& s : checkpoint.stats)
+	{
+		stats.emplace_back(s.y);
+	}
+	const double previous_elapsed = checkpoint.elapsed;
+	double last_save = 0.0;
+
+	run_blocks_in_order(pool, checkpoint.next_block, num_blocks,
+		[&](std::size_t block) {return simulate_block_(spot, num_scenarios, seed, block);},
+		[&](std::size_t block, std::vector<RunningStats>&& block_stats)
+		{
+			for (std::size_t k = 0; k < stats.size(); ++k)
+			{
+				stats[k].merge(block_stats[k]);
+			}
+
+			tmr.stop();
+			if (block + 1 == num_blocks || tmr.milliseconds() - last_save >= checkpoint_interval)
+			{
+				checkpoint.next_block = block + 1;
+				checkpoint.elapsed = previous_elapsed + tmr.milliseconds();
+				for (std::size_t k = 0; k < stats.size(); ++k)
+				{
+					checkpoint.stats[k].y = stats[k].state();
+				}
+				write_checkpoint_file(checkpoint_file, checkpoint);
+				last_save = tmr.milliseconds();
+			}
+			return true;
+		});
+
+	tmr.stop();
+	return make_results_(stats, num_scenarios, previous_elapsed + tmr.milliseconds());
+}
+
+std::vector<RunningStats> MCPortfolioValuation::simulate_block_(double spot,
+	std::size_t num_scenarios, std::uint64_t seed, std::size_t block) const
+{
+	using std::vector;
+
+	const std::size_t first = block * paths_per_block;
+	const std::size_t last = std::min(first + paths_per_block, num_scenarios);
+	const std::size_t num_points = times_.size();
+
+	vector<double> disc_factors;
+	for (const auto& opt : opts_)
+	{
+		disc_factors.push_back(std::exp(-int_rate_ * std::max(opt.time_to_expiration(), 0.0)));
+	}
+
+	vector<RunningStats> stats(opts_.size());
+	vector<double> path(num_points);
+	vector<double> alive(distinct_barriers_.size() * num_points);	// Row per barrier
+
+	for (std::size_t i = first; i < last; ++i)
+	{
+		// (1) Generate the path once:
+		Philox4x32 rng{seed, i};
+		ZigguratNormal zn;
+		path[0] = spot;
+		for (std::size_t j = 1; j < num_points; ++j)
+		{
+			path[j] = path[j - 1] * std::exp(step_drift_[j - 1] + step_vol_[j - 1] * zn(rng));
+		}
+
+		// (2) The knock-out weights, once per distinct barrier:
+		for (std::size_t b = 0; b < distinct_barriers_.size(); ++b)
+		{
+			alive_weights_(path, distinct_barriers_[b],
+				std::span{alive}.subspan(b * num_points, num_points));
+		}
+
+		// (3) Every instrument, against the same path:
+		for (std::size_t k = 0; k < opts_.size(); ++k)
+		{
+			const std::size_t e = expiry_step_[k];
+			const double weight = (barrier_idx_[k] < 0) ? 1.0 : alive[barrier_idx_[k] * num_points + e];
+			stats[k].add(weight == 0.0 ? 0.0 : weight * disc_factors[k] * opts_[k].option_payoff(path[e]));
+		}
+	}
+
+	return stats;
+}
+
+void MCPortfolioValuation::alive_weights_(std::span<const double> path,
+	const MonitoredBarrier& monitored, std::span<double> alive) const
+{
+	const BarrierSpec& barrier = monitored.spec;
+	const bool up = barrier.type == BarrierType::up_and_out;
+	auto hit = [up, &barrier](double sim_eq)
+		{return up ? sim_eq >= barrier.value : sim_eq <= barrier.value;};
+
+	double weight = hit(path[0]) ? 0.0 : 1.0;
+	alive[0] = weight;
+
+	const bool bridge = barrier_monitoring_ == BarrierMonitoring::brownian_bridge;
+	for (std::size_t j = 1; j < path.size(); ++j)
+	{
+		if (weight != 0.0 && (bridge || monitored.monitored[j]))
+		{
+			if (hit(path[j]))
+			{
+				weight = 0.0;
+			}
+			else if (bridge)
+			{
+				// Probability that the bridge from path[j - 1] to path[j] crosses:
+				const double var = step_vol_[j - 1] * step_vol_[j - 1];
+				weight *= 1.0 - std::exp(-2.0 * std::log(path[j - 1] / barrier.value)
+					* std::log(path[j] / barrier.value) / var);
+			}
+		}
+		alive[j] = weight;
+	}
+}
+
+std::vector<MCResult> MCPortfolioValuation::make_results_(const std::vector<RunningStats>& stats,
+	std::uint64_t num_paths, double elapsed) const
+{
+	std::vector<MCResult> results;
+	results.reserve(stats.size());
+	for (const auto& s : stats)
+	{
+		results.push_back(MCResult{s.mean(), s.std_error(), num_paths, elapsed});
+	}
+	return results;
+}
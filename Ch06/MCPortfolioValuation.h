@@ -0,0 +1,125 @@
+/*
+ * This file is licensed under the Mozilla Public License, v. 2.0.
+ * You can obtain a copy of the license at http://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#include "OptionInfo.h"
+#include "MCOptionValuation.h"		// BarrierType, BarrierMonitoring, MCResult
+#include "ThreadPool.h"
+#include "RunningStats.h"
+#include "MCShard.h"
+#include "MCCheckpoint.h"
+
+#include <vector>
+#include <span>
+#include <filesystem>
+#include <cstdint>
+#include <cstddef>
+
+// Knock-out barrier of an instrument in a portfolio (none by default):
+struct BarrierSpec
+{
+	BarrierType type{BarrierType::none};
+	double value{0.0};
+};
+
+// Values a book of options on one underlying from a single set of simulated
+// paths.  Each path is generated once, on a time grid holding the expiration
+// of every option and the monitoring dates of every barrier option, and every
+// instrument is then evaluated against it.  The barrier of an option is
+// monitored at its own dates, the time_steps equal steps up to its
+// expiration, whatever the other options in the book (or continuously, with
+// BarrierMonitoring::brownian_bridge), so its price does not depend on the
+// rest of the book.  The knock-out state is computed once per path for each
+// distinct barrier and expiration, so the cost per path grows with the number
+// of those rather than the number of options.
+//
+// Path i draws from the stream Philox4x32{seed, i}, and paths are simulated
+// in blocks whose statistics are merged in order, as in MCOptionValuation.
+class MCPortfolioValuation
+{
+public:
+	// `barriers` is either empty (no barriers), or holds one spec per option:
+	MCPortfolioValuation(std::vector<OptionInfo>&& opts, std::vector<BarrierSpec> barriers,
+		int time_steps, double vol, double int_rate, double div_rate = 0.0);
+
+	std::size_t size() const;
+
+	// One result per option, in the order given to the constructor.  Each holds
+	// the price and standard error of that option; elapsed is for the whole book:
+	std::vector<MCResult> calc_prices(double spot, int num_scenarios, unsigned unif_start_seed);
+	std::vector<MCResult> calc_prices(double spot, int num_scenarios, unsigned unif_start_seed,
+		ThreadPool& pool);
+
+	// Runs the paths [first_path, last_path) of calc_prices(spot, num_scenarios,
+	// unif_start_seed), as one shard of a run split across processes (see
+	// MCShard.h and MCOptionValuation::calc_price_shard(.)), with the statistics
+	// of each instrument in each block.  merge_shards(.) combines the shards of
+	// a run into the results of calc_prices(.), bit for bit, and throws
+	// std::invalid_argument for shards of a different book or settings:
+	MCShard calc_prices_shard(double spot, int num_scenarios, unsigned unif_start_seed,
+		std::uint64_t first_path, std::uint64_t last_path);
+	MCShard calc_prices_shard(double spot, int num_scenarios, unsigned unif_start_seed,
+		std::uint64_t first_path, std::uint64_t last_path, ThreadPool& pool);
+	std::vector<MCResult> merge_shards(std::vector<MCShard> shards) const;
+
+	// calc_prices(.), saving its progress to checkpoint_file, and resuming from
+	// it, as MCOptionValuation::calc_price_checkpointed(.) does:
+	std::vector<MCResult> calc_prices_checkpointed(double spot, int num_scenarios,
+		unsigned unif_start_seed, const std::filesystem::path& checkpoint_file,
+		double checkpoint_interval = 60'000.0);
+	std::vector<MCResult> calc_prices_checkpointed(double spot, int num_scenarios,
+		unsigned unif_start_seed, const std::filesystem::path& checkpoint_file,
+		double checkpoint_interval, ThreadPool& pool);
+
+	// BarrierMonitoring::discrete (default) or BarrierMonitoring::brownian_bridge.
+	// The BGK shift assumes equal time steps, so is not supported here:
+	void set_barrier_monitoring(BarrierMonitoring monitoring);
+
+private:
+	std::vector<OptionInfo> opts_;
+	std::vector<std::size_t> expiry_step_;		// Grid index of each option's expiration
+	std::vector<int> barrier_idx_;				// Index into distinct_barriers_, or -1
+
+	// A distinct barrier and expiration, with the grid points of its
+	// monitoring dates:
+	struct MonitoredBarrier
+	{
+		BarrierSpec spec;
+		double expiry;
+		std::vector<bool> monitored;
+	};
+	std::vector<MonitoredBarrier> distinct_barriers_;
+
+	double vol_, int_rate_, div_rate_;
+	BarrierMonitoring barrier_monitoring_{BarrierMonitoring::discrete};
+
+	std::vector<double> times_;					// Time grid, times_[0] = 0
+	std::vector<double> step_drift_, step_vol_;	// Per step (r - q - vol^2/2) dt and vol sqrt(dt)
+
+	static constexpr std::size_t paths_per_block = 4096;
+	std::vector<RunningStats> simulate_block_(double spot, std::size_t num_scenarios,
+		std::uint64_t seed, std::size_t block) const;
+
+	// Fingerprint of the book, its time grid, and its settings, kept in shard
+	// and checkpoint files (see Fingerprint.h):
+	std::uint64_t fingerprint_(double spot) const;
+
+	MCShard run_shard_(double spot, int num_scenarios, std::uint64_t seed,
+		std::uint64_t first_path, std::uint64_t last_path, ThreadPool* pool) const;
+	std::vector<MCResult> run_checkpointed_(double spot, int num_scenarios, std::uint64_t seed,
+		const std::filesystem::path& checkpoint_file, double checkpoint_interval,
+		ThreadPool* pool) const;
+
+	// Fills alive with the knock-out weight of the path at each grid point:
+	// 1 until the barrier is hit at one of its monitoring dates and 0 from then
+	// on, or, with Brownian-bridge monitoring, the probability of no crossing
+	// up to that point:
+	void alive_weights_(std::span<const double> path, const MonitoredBarrier& monitored,
+		std::span<double> alive) const;
+
+	std::vector<MCResult> make_results_(const std::vector<RunningStats>& stats,
+		std::uint64_t num_paths, double elapsed) const;
+};
@@ -0,0 +1,212 @@
+/*
+ * This file is licensed under the Mozilla Public License, v. 2.0.
+ * You can obtain a copy of the license at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "MCShard.h"
+
+#include <fstream>
+#include <algorithm>
+#include <stdexcept>
+#include <type_traits>
+#include <system_error>
+#include <string>
+#include <utility>
+#include <cstring>		// std::memcpy, std::memcmp
+
+namespace
+{
+	constexpr char shard_magic[8] = {'M', 'C', 'S', 'H', 'A', 'R', 'D', 'S'};
+	constexpr std::uint32_t shard_version = 2;
+
+	// Fixed-size start of a shard file, followed by the stats, steps_simulated,
+	// and steps_saved arrays of the shard:
+	struct ShardHeader
+	{
+		char magic[8];
+		std::uint32_t version;
+		std::uint32_t reserved;
+		std::uint64_t seed;
+		std::uint64_t num_scenarios;
+		std::uint64_t paths_per_block;
+		std::uint64_t first_block;
+		std::uint64_t num_blocks;
+		std::uint64_t num_instruments;
+		double spot;
+		std::uint64_t fingerprint;
+		double elapsed;
+	};
+
+	static_assert(sizeof(ShardHeader) == 88);
+	static_assert(std::is_trivially_copyable_v<RunningCovariance::State>);
+
+	template<typename T>
+	void write_array(std::ofstream& file, const std::vector<T>& values)
+	{
+		file.write(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(T));
+	}
+
+	template<typename T>
+	void read_array(std::ifstream& file, std::vector<T>& values, std::uint64_t size)
+	{
+		values.resize(size);
+		file.read(reinterpret_cast<char*>(values.data()), size * sizeof(T));
+	}
+}
+
+std::pair<std::uint64_t, std::uint64_t> shard_paths(std::uint64_t num_scenarios,
+	unsigned shard, unsigned num_shards, std::uint64_t paths_per_block)
+{
+	if (shard >= num_shards || paths_per_block == 0)
+	{
+		throw std::invalid_argument{"shard_paths: no such shard"};
+	}
+
+	const std::uint64_t num_blocks = (num_scenarios + paths_per_block - 1) / paths_per_block;
+	const std::uint64_t first_block = num_blocks * shard / num_shards;
+	const std::uint64_t last_block = num_blocks * (shard + 1) / num_shards;
+	return {std::min(first_block * paths_per_block, num_scenarios),
+		std::min(last_block * paths_per_block, num_scenarios)};
+}
+
+std::pair<std::uint64_t, std::uint64_t> shard_blocks(std::uint64_t num_scenarios,
+	std::uint64_t paths_per_block, std::uint64_t first_path, std::uint64_t last_path)
+{
+	if (first_path > last_path || last_path > num_scenarios)
+	{
+		throw std::invalid_argument{"shard_blocks: the paths are not in the run"};
+	}
+	if (first_path % paths_per_block != 0
+		|| (last_path % paths_per_block != 0 && last_path != num_scenarios))
+	{
+		throw std::invalid_argument{"shard_blocks: the paths are not whole blocks of "
+			+ std::to_string(paths_per_block)};
+	}
+
+	return {first_path / paths_per_block, (last_path + paths_per_block - 1) / paths_per_block};
+}
+
+void write_shard_file(const std::filesystem::path& file_name, const MCShard& shard)
+{
+	if (shard.stats.size() != shard.num_blocks * shard.num_instruments
+		|| shard.steps_simulated.size() != shard.num_blocks
+		|| shard.steps_saved.size() != shard.num_blocks)
+	{
+		throw std::invalid_argument{"write_shard_file: inconsistent shard"};
+	}
+
+	ShardHeader header{};
+	std::memcpy(header.magic, shard_magic, sizeof(header.magic));
+	header.version = shard_version;
+	header.seed = shard.seed;
+	header.num_scenarios = shard.num_scenarios;
+	header.paths_per_block = shard.paths_per_block;
+	header.first_block = shard.first_block;
+	header.num_blocks = shard.num_blocks;
+	header.num_instruments = shard.num_instruments;
+	header.spot = shard.spot;
+	header.fingerprint = shard.fingerprint;
+	header.elapsed = shard.elapsed;
+
+	std::ofstream file{file_name, std::ios::binary | std::ios::trunc};
+	if (!file)
+	{
+		throw std::runtime_error{"write_shard_file: cannot open " + file_name.string()};
+	}
+
+	file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	write_array(file, shard.stats);
+	write_array(file, shard.steps_simulated);
+	write_array(file, shard.steps_saved);
+
+	file.close();
+	if (!file)
+	{
+		throw std::runtime_error{"write_shard_file: error writing " + file_name.string()};
+	}
+}
+
+MCShard read_shard_file(const std::filesystem::path& file_name)
+{
+	const std::string name = file_name.string();
+
+	std::ifstream file{file_name, std::ios::binary};
+	std::error_code ec;
+	const std::uintmax_t file_size = std::filesystem::file_size(file_name, ec);
+	if (!file || ec)
+	{
+		throw std::runtime_error{"read_shard_file: cannot open " + name};
+	}
+
+	// The header is checked, and the size of the file against it, before
+	// anything is allocated:
+	ShardHeader header{};
+	file.read(reinterpret_cast<char*>(&header), sizeof(header));
+	bool valid = file && std::memcmp(header.magic, shard_magic, sizeof(header.magic)) == 0
+		&& header.version == shard_version && header.paths_per_block > 0
+		&& header.num_instruments > 0;
+	if (valid)
+	{
+		const std::uintmax_t payload = file_size - sizeof(ShardHeader);
+		constexpr std::uintmax_t block_bytes = 2 * sizeof(std::uint64_t);
+		constexpr std::uintmax_t stats_bytes = sizeof(RunningCovariance::State);
+		valid = header.num_blocks == 0 ? payload == 0
+			: payload % header.num_blocks == 0 && header.num_instruments <= payload / stats_bytes
+				&& payload / header.num_blocks == header.num_instruments * stats_bytes + block_bytes;
+	}
+	if (!valid)
+	{
+		throw std::runtime_error{"read_shard_file: " + name + " is not a valid shard file"};
+	}
+
+	MCShard shard{header.seed, header.num_scenarios, header.paths_per_block, header.first_block,
+		header.num_blocks, header.num_instruments, header.spot, header.fingerprint, header.elapsed,
+		{}, {}, {}};
+	read_array(file, shard.stats, header.num_blocks * header.num_instruments);
+	read_array(file, shard.steps_simulated, header.num_blocks);
+	read_array(file, shard.steps_saved, header.num_blocks);
+	if (!file)
+	{
+		throw std::runtime_error{"read_shard_file: error reading " + name};
+	}
+
+	return shard;
+}
+
+std::vector<MCShard> order_shards(std::vector<MCShard> shards)
+{
+	if (shards.empty())
+	{
+		throw std::invalid_argument{"order_shards: no shards"};
+	}
+
+	std::ranges::sort(shards, {},
+		[](const MCShard& shard) {return std::pair{shard.first_block, shard.num_blocks};});
+
+	const MCShard& run = shards.front();
+	const std::uint64_t num_blocks =
+		(run.num_scenarios + run.paths_per_block - 1) / run.paths_per_block;
+	std::uint64_t next_block = 0;
+	for (const auto& shard : shards)
+	{
+		if (shard.seed != run.seed || shard.num_scenarios != run.num_scenarios
+			|| shard.paths_per_block != run.paths_per_block
+			|| shard.num_instruments != run.num_instruments || shard.spot != run.spot
+			|| shard.fingerprint != run.fingerprint)
+		{
+			throw std::invalid_argument{"order_shards: the shards are of different runs"};
+		}
+		if (shard.first_block != next_block)
+		{
+			throw std::invalid_argument{"order_shards: the shards overlap, or leave a gap"};
+		}
+		next_block += shard.num_blocks;
+	}
+
+	if (next_block != num_blocks)
+	{
+		throw std::invalid_argument{"order_shards: the shards do not cover the run"};
+	}
+
+	return shards;
+}
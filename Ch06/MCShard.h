@@ -0,0 +1,67 @@
+/*
+ * This file is licensed under the Mozilla Public License, v. 2.0.
+ * You can obtain a copy of the license at http://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#include "RunningStats.h"
+
+#include <filesystem>
+#include <vector>
+#include <utility>		// std::pair
+#include <cstdint>
+#include <cstddef>
+
+// One shard of a Monte Carlo run split across processes (or machines): the
+// statistics of the blocks [first_block, first_block + num_blocks) of a run of
+// num_scenarios paths with a given seed, in which path i draws from the stream
+// Philox4x32{seed, i}.  Shards are produced by calc_price_shard(.) of
+// MCOptionValuation, or calc_prices_shard(.) of MCPortfolioValuation, and
+// combined by merge_shards(.) of the same class.  A single-process run merges
+// the statistics of its blocks in block order; as a shard keeps the statistics
+// of each of its blocks, rather than their sum, merge_shards(.) can do exactly
+// the same, and its result is bit-identical to that of the single-process run.
+// The fingerprint of the parameters and settings of the valuation (see
+// Fingerprint.h) keeps the shards of different valuations apart.
+struct MCShard
+{
+	std::uint64_t seed{0};
+	std::uint64_t num_scenarios{0};		// Of the whole run
+	std::uint64_t paths_per_block{0};
+	std::uint64_t first_block{0};
+	std::uint64_t num_blocks{0};
+	std::uint64_t num_instruments{0};
+	double spot{0.0};
+	std::uint64_t fingerprint{0};
+	double elapsed{0.0};				// Time (msec) to run the shard
+
+	// Statistics of the pairs (discounted control, discounted payoff) of each
+	// block, then of each instrument in the block (the control being zero when
+	// there is none), and the time steps simulated and skipped in each block:
+	std::vector<RunningCovariance::State> stats;
+	std::vector<std::uint64_t> steps_simulated;
+	std::vector<std::uint64_t> steps_saved;
+};
+
+// The paths [first, last) of shard `shard` of num_shards (0 <= shard < num_shards):
+// whole blocks of paths_per_block paths, split as evenly as possible, and
+// together covering [0, num_scenarios):
+std::pair<std::uint64_t, std::uint64_t> shard_paths(std::uint64_t num_scenarios,
+	unsigned shard, unsigned num_shards, std::uint64_t paths_per_block = 4096);
+
+// The blocks [first, last) of the paths [first_path, last_path), which must be
+// whole blocks of the run, other than the last block of the run (throws
+// std::invalid_argument otherwise):
+std::pair<std::uint64_t, std::uint64_t> shard_blocks(std::uint64_t num_scenarios,
+	std::uint64_t paths_per_block, std::uint64_t first_path, std::uint64_t last_path);
+
+// Binary shard files, in the native byte order.  Both throw std::runtime_error
+// if the file cannot be written or read, or is not a valid shard file:
+void write_shard_file(const std::filesystem::path& file_name, const MCShard& shard);
+MCShard read_shard_file(const std::filesystem::path& file_name);
+
+// The shards in block order, having checked that they are all of the same run
+// (and fingerprint), and between them cover each of its blocks exactly once
+// (throws std::invalid_argument otherwise):
+std::vector<MCShard> order_shards(std::vector<MCShard> shards);
@@ -0,0 +1,111 @@
+/*
+ * This file is licensed under the Mozilla Public License, v. 2.0.
+ * You can obtain a copy of the license at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "MultiAssetPathGenerator.h"
+#include "Philox.h"
+#include "NormalSamplers.h"
+
+#include <utility>		// std::move
+#include <vector>
+#include <span>
+#include <cmath>
+#include <stdexcept>
+
+using Eigen::MatrixXd, Eigen::VectorXd;
+
+MultiAssetPathGenerator::MultiAssetPathGenerator(VectorXd spots, const MatrixXd& covariance,
+	double time_to_expiration, int num_time_steps, double rf_rate, VectorXd div_rates) :
+	spots_{std::move(spots)}, time_to_expiration_{time_to_expiration},
+	num_time_steps_{num_time_steps}, rf_rate_{rf_rate}
+{
+	const Eigen::Index n = spots_.size();
+	if (covariance.rows() != n || covariance.cols() != n || div_rates.size() != n)
+	{
+		throw std::invalid_argument{"MultiAssetPathGenerator: need one spot and dividend rate "
+			"per row and column of the covariance matrix"};
+	}
+	if (num_time_steps_ < 1 || (spots_.array() <= 0.0).any())
+	{
+		throw std::invalid_argument{"MultiAssetPathGenerator: need positive spots and time steps"};
+	}
+
+	Eigen::LLT<MatrixXd> chol{covariance};
+	if (chol.info() != Eigen::Success)
+	{
+		throw std::invalid_argument{"MultiAssetPathGenerator: covariance matrix is not positive definite"};
+	}
+
+	const double dt = time_to_expiration_ / num_time_steps_;
+	log_spots_ = spots_.array().log();
+	drift_ = ((rf_rate_ - div_rates.array()) - covariance.diagonal().array() / 2.0) * dt;
+	chol_sqrt_dt_ = MatrixXd{chol.matrixL()} * std::sqrt(dt);
+}
+
+Eigen::Index MultiAssetPathGenerator::num_assets() const
+{
+	return spots_.size();
+}
+
+const VectorXd& MultiAssetPathGenerator::spots() const
+{
+	return spots_;
+}
+
+double MultiAssetPathGenerator::time_to_expiration() const
+{
+	return time_to_expiration_;
+}
+
+double MultiAssetPathGenerator::rf_rate() const
+{
+	return rf_rate_;
+}
+
+void MultiAssetPathGenerator::terminal_prices(std::uint64_t seed, std::size_t first_path,
+	Eigen::Ref<MatrixXd> prices) const
+{
+	std::vector<Philox4x32> rngs = make_streams_(seed, first_path, prices);
+
+	// Log prices of the block, stepped in place:
+	MatrixXd log_prices = log_spots_.replicate(1, prices.cols());
+	MatrixXd normals(num_assets(), prices.cols());
+
+	for (int step = 1; step <= num_time_steps_; ++step)
+	{
+		step_(rngs, normals, log_prices);
+	}
+
+	prices = log_prices.array().exp();
+}
+
+std::vector<Philox4x32> MultiAssetPathGenerator::make_streams_(std::uint64_t seed,
+	std::size_t first_path, const Eigen::Ref<MatrixXd>& prices) const
+{
+	if (prices.rows() != num_assets())
+	{
+		throw std::invalid_argument{"MultiAssetPathGenerator: prices must have one row per asset"};
+	}
+
+	std::vector<Philox4x32> rngs;
+	rngs.reserve(prices.cols());
+	for (Eigen::Index j = 0; j < prices.cols(); ++j)
+	{
+		rngs.emplace_back(seed, first_path + j);
+	}
+	return rngs;
+}
+
+void MultiAssetPathGenerator::step_(std::vector<Philox4x32>& rngs, MatrixXd& normals,
+	MatrixXd& log_prices) const
+{
+	ZigguratNormal zn;
+	for (Eigen::Index j = 0; j < normals.cols(); ++j)
+	{
+		zn.fill(rngs[j], std::span{normals.col(j).data(), static_cast<std::size_t>(normals.rows())});
+	}
+
+	log_prices.noalias() += chol_sqrt_dt_ * normals;	// One GEMM per step
+	log_prices.colwise() += drift_;
+}
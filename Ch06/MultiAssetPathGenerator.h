@@ -0,0 +1,87 @@
+/*
+ * This file is licensed under the Mozilla Public License, v. 2.0.
+ * You can obtain a copy of the license at http://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#include "Philox.h"
+
+#include <Eigen/Dense>
+#include <vector>
+#include <utility>		// std::as_const
+#include <cstdint>
+#include <cstddef>
+
+// Correlated geometric Brownian motion for a basket of assets.  The (annual)
+// covariance matrix of the log returns is factored once, with a Cholesky (LLT)
+// decomposition, as in cholesky_correlated_random_equity_paths() in Ch08; each
+// time step then moves a whole block of paths with one matrix product,
+// L sqrt(dt) * Z, where Z holds a standard normal per asset (rows) and path
+// (columns).
+//
+// Only the current prices of a block are kept, never the paths x assets x
+// steps tensor.  Path first_path + j draws its normals from the stream
+// Philox4x32{seed, first_path + j}, so the results do not depend on how the
+// paths are split into blocks or across threads.
+class MultiAssetPathGenerator
+{
+public:
+	MultiAssetPathGenerator(Eigen::VectorXd spots, const Eigen::MatrixXd& covariance,
+		double time_to_expiration, int num_time_steps, double rf_rate,
+		Eigen::VectorXd div_rates);
+
+	Eigen::Index num_assets() const;
+	const Eigen::VectorXd& spots() const;
+	double time_to_expiration() const;
+	double rf_rate() const;
+
+	// Simulates paths first_path, ..., first_path + prices.cols() - 1 to
+	// expiration, and writes their prices there to the columns of `prices`,
+	// which must have num_assets() rows:
+	void terminal_prices(std::uint64_t seed, std::size_t first_path,
+		Eigen::Ref<Eigen::MatrixXd> prices) const;
+
+	// The same, but also calls on_step(step, prices) after each time step
+	// (step = 1, ..., num_time_steps), with the prices of the block at that
+	// time (as a const Eigen::Ref<Eigen::MatrixXd>&), for payoffs that depend
+	// on more than the prices at expiration:
+	template<typename F>
+	void simulate(std::uint64_t seed, std::size_t first_path,
+		Eigen::Ref<Eigen::MatrixXd> prices, F&& on_step) const;
+
+private:
+	Eigen::VectorXd spots_;
+	double time_to_expiration_;
+	int num_time_steps_;
+	double rf_rate_;
+
+	Eigen::VectorXd log_spots_;
+	Eigen::VectorXd drift_;				// Per asset (r - q - vol^2/2) dt
+	Eigen::MatrixXd chol_sqrt_dt_;		// Cholesky factor of the covariance, times sqrt(dt)
+
+	// One stream per column of prices (after checking it has a row per asset):
+	std::vector<Philox4x32> make_streams_(std::uint64_t seed, std::size_t first_path,
+		const Eigen::Ref<Eigen::MatrixXd>& prices) const;
+
+	// Moves the log prices of a block on by one time step, drawing the
+	// normals of path j from rngs[j]:
+	void step_(std::vector<Philox4x32>& rngs, Eigen::MatrixXd& normals,
+		Eigen::MatrixXd& log_prices) const;
+};
+
+template<typename F>
+void MultiAssetPathGenerator::simulate(std::uint64_t seed, std::size_t first_path,
+	Eigen::Ref<Eigen::MatrixXd> prices, F&& on_step) const
+{
+	std::vector<Philox4x32> rngs = make_streams_(seed, first_path, prices);
+	Eigen::MatrixXd log_prices = log_spots_.replicate(1, prices.cols());
+	Eigen::MatrixXd normals(num_assets(), prices.cols());
+
+	for (int step = 1; step <= num_time_steps_; ++step)
+	{
+		step_(rngs, normals, log_prices);
+		prices = log_prices.array().exp();
+		on_step(step, std::as_const(prices));
+	}
+}
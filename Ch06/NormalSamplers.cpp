@@ -0,0 +1,99 @@
+/*
+ * This file is licensed under the Mozilla Public License, v. 2.0.
+ * You can obtain a copy of the license at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "NormalSamplers.h"
+
+#include <cmath>
+#include <numbers>
+#include <limits>
+
+// Acklam's rational approximation (relative error < 1.15e-9):
+double approx_inverse_normal_cdf(double p)
+{
+	if (p <= 0.0) return -std::numeric_limits<double>::infinity();
+	if (p >= 1.0) return std::numeric_limits<double>::infinity();
+
+	constexpr double a[] = {-3.969683028665376e+01, 2.209460984245205e+02,
+		-2.759285104469687e+02, 1.383577518672690e+02, -3.066479806614716e+01,
+		2.506628277459239e+00};
+	constexpr double b[] = {-5.447609879822406e+01, 1.615858368580409e+02,
+		-1.556989798598866e+02, 6.680131188771972e+01, -1.328068155288572e+01};
+	constexpr double c[] = {-7.784894002430293e-03, -3.223964580411365e-01,
+		-2.400758277161838e+00, -2.549732539343734e+00, 4.374664141464968e+00,
+		2.938163982698783e+00};
+	constexpr double d[] = {7.784695709041462e-03, 3.224671290700398e-01,
+		2.445134137142996e+00, 3.754408661907416e+00};
+	constexpr double p_low = 0.02425;
+
+	double x{0.0};
+	if (p < p_low)					// Lower tail
+	{
+		double q = std::sqrt(-2.0 * std::log(p));
+		x = (((((c[0] * q + c[1]) * q + c[2]) * q + c[3]) * q + c[4]) * q + c[5])
+			/ ((((d[0] * q + d[1]) * q + d[2]) * q + d[3]) * q + 1.0);
+	}
+	else if (p <= 1.0 - p_low)		// Central region
+	{
+		double q = p - 0.5;
+		double r = q * q;
+		x = (((((a[0] * r + a[1]) * r + a[2]) * r + a[3]) * r + a[4]) * r + a[5]) * q
+			/ (((((b[0] * r + b[1]) * r + b[2]) * r + b[3]) * r + b[4]) * r + 1.0);
+	}
+	else							// Upper tail
+	{
+		double q = std::sqrt(-2.0 * std::log1p(-p));
+		x = -(((((c[0] * q + c[1]) * q + c[2]) * q + c[3]) * q + c[4]) * q + c[5])
+			/ ((((d[0] * q + d[1]) * q + d[2]) * q + d[3]) * q + 1.0);
+	}
+
+	return x;
+}
+
+// Acklam's approximation, followed by one step of Halley's method on N(x) - p,
+// which takes it to full double precision.
+double inverse_normal_cdf(double p)
+{
+	if (p <= 0.0) return -std::numeric_limits<double>::infinity();
+	if (p >= 1.0) return std::numeric_limits<double>::infinity();
+
+	const double x = approx_inverse_normal_cdf(p);
+
+	// Halley refinement, with N(x) computed from erfc to keep tail accuracy:
+	using namespace std::numbers;
+	double e = 0.5 * std::erfc(-x / sqrt2) - p;
+	double u = e * std::sqrt(2.0 * pi) * std::exp(x * x / 2.0);
+	return x - u / (1.0 + x * u / 2.0);
+}
+
+ZigguratNormal::ZigguratNormal() : t_{&tables_()} {}
+
+const ZigguratNormal::Tables& ZigguratNormal::tables_()
+{
+	// Each layer (and the base, with the tail beyond r) has area v.  The value of
+	// r for 256 layers is from Marsaglia and Tsang; the table is built once:
+	static const Tables tables = []
+		{
+			constexpr double r = 3.6541528853610088;
+			auto f = [](double x) {return std::exp(-0.5 * x * x);};
+			const double v = r * f(r) + std::sqrt(std::numbers::pi / 2.0) * std::erfc(r / std::numbers::sqrt2);
+
+			Tables t;
+			t.x[0] = v / f(r);
+			t.x[1] = r;
+			for (std::size_t i = 1; i < layers - 1; ++i)
+			{
+				t.x[i + 1] = std::sqrt(-2.0 * std::log(v / t.x[i] + f(t.x[i])));
+			}
+			t.x[layers] = 0.0;
+
+			for (std::size_t i = 0; i <= layers; ++i)
+			{
+				t.f[i] = f(t.x[i]);
+			}
+			return t;
+		}();
+
+	return tables;
+}
@@ -16,11 +16,29 @@
 // of a raw pointer and "virtual constructor" as seen in the C++03 version above.
 
 OptionInfo::OptionInfo(std::unique_ptr<Payoff> payoff, double time_to_exp) :
-	payoff_ptr_{std::move(payoff)}, time_to_exp_{time_to_exp} {}
+	payoff_{make_payoff_variant_(std::move(payoff))}, time_to_exp_{time_to_exp} {}
 
-double OptionInfo::option_payoff(double spot) const
+// option_payoff(.) is defined inline in OptionInfo.h.
+
+double OptionInfo::option_payoff_derivative(double spot) const
 {
-	return payoff_ptr_->payoff(spot);
+	return visit_payoff([spot](const auto& payoff) { return payoff.payoff_derivative(spot); });
+}
+
+void OptionInfo::option_payoffs(std::span<const double> spots, std::span<double> payoffs) const
+{
+	if (payoffs.size() < spots.size())
+	{
+		throw std::invalid_argument{"OptionInfo::option_payoffs: payoffs is shorter than spots"};
+	}
+
+	visit_payoff([spots, payoffs](const auto& payoff)
+		{
+			for (std::size_t k = 0; k < spots.size(); ++k)
+			{
+				payoffs[k] = payoff.payoff(spots[k]);
+			}
+		});
 }
 
 double OptionInfo::time_to_expiration() const
@@ -28,17 +46,27 @@ double OptionInfo::time_to_expiration() const
 	return time_to_exp_;
 }
 
+PathDependence OptionInfo::path_dependence() const
+{
+	return visit_payoff([](const auto& payoff) { return payoff.path_dependence(); });
+}
+
+bool OptionInfo::continuous_payoff() const
+{
+	return visit_payoff([](const auto& payoff) { return payoff.is_continuous(); });
+}
+
 void OptionInfo::swap(OptionInfo& rhs) noexcept
 {
 	using std::swap;
-	swap(payoff_ptr_, rhs.payoff_ptr_);
+	swap(payoff_, rhs.payoff_);
 	swap(time_to_exp_, rhs.time_to_exp_);
 	//throw std::runtime_error{"Error:..."};	// Compiler warning, runtime error (for demonstration)
 }
 
 // Copy Constructor:
 OptionInfo::OptionInfo(const OptionInfo& rhs) :
-	payoff_ptr_{rhs.payoff_ptr_->clone()}, 
+	payoff_{rhs.visit_payoff([](const auto& payoff) { return make_payoff_variant_(payoff.clone()); })},
 	time_to_exp_{rhs.time_to_expiration()} {}
 
 // Copy Assignment:
@@ -50,3 +78,13 @@ OptionInfo& OptionInfo::operator =(const OptionInfo& rhs) noexcept
 
 
 
+
+
+// The final Payoff types are held by value; any other is kept behind its pointer:
+PayoffVariant OptionInfo::make_payoff_variant_(std::unique_ptr<Payoff> payoff)
+{
+	if (auto call = dynamic_cast<const CallPayoff*>(payoff.get())) return *call;
+	if (auto put = dynamic_cast<const PutPayoff*>(payoff.get())) return *put;
+	if (auto digital = dynamic_cast<const DigitalPayoff*>(payoff.get())) return *digital;
+	return payoff;
+}
\ No newline at end of file
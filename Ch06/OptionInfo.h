@@ -7,13 +7,38 @@
 
 #include "Payoffs.h"
 #include <memory>
+#include <variant>
+#include <span>
+#include <type_traits>
+
+// The payoff is held in a closed std::variant of the final Payoff classes,
+// so that it is evaluated without a virtual call, and can be inlined into a
+// pricing loop.  The constructor still takes any unique_ptr<Payoff>: one of
+// the types below is copied into the variant, and any other (open)
+// extension of Payoff is kept behind its pointer, as before.
+using PayoffVariant = std::variant<CallPayoff, PutPayoff, DigitalPayoff,
+	std::unique_ptr<Payoff>>;
 
 class OptionInfo
 {
 public:
 	OptionInfo(std::unique_ptr<Payoff> payoff, double time_to_exp);
 	double option_payoff(double spot) const;
+	double option_payoff_derivative(double spot) const;		// d payoff / d spot
+
+	// Payoffs of a batch of prices, dispatching on the payoff type once, rather
+	// than once per price, so that the loop can be vectorized:
+	void option_payoffs(std::span<const double> spots, std::span<double> payoffs) const;
+
+	// Calls f(payoff), with payoff a const reference to the concrete final
+	// Payoff type (or to the base class for an open extension), so that a
+	// pricer can hoist the dispatch out of its loop:
+	template<typename F>
+	decltype(auto) visit_payoff(F&& f) const;
+
 	double time_to_expiration() const;
+	PathDependence path_dependence() const;
+	bool continuous_payoff() const;
 	void swap(OptionInfo& rhs) noexcept;
 
 	OptionInfo(const OptionInfo& rhs);
@@ -26,9 +51,28 @@ public:
 	~OptionInfo() = default;								// Default destructor
 
 private:
-	std::unique_ptr<Payoff> payoff_ptr_;
+	PayoffVariant payoff_;
 	double time_to_exp_;
+
+	static PayoffVariant make_payoff_variant_(std::unique_ptr<Payoff> payoff);
 };
 
+template<typename F>
+decltype(auto) OptionInfo::visit_payoff(F&& f) const
+{
+	return std::visit([&f](const auto& payoff) -> decltype(auto)
+		{
+			if constexpr (std::is_same_v<std::decay_t<decltype(payoff)>, std::unique_ptr<Payoff>>)
+				return f(static_cast<const Payoff&>(*payoff));
+			else
+				return f(payoff);
+		}, payoff_);
+}
+
+inline double OptionInfo::option_payoff(double spot) const
+{
+	return visit_payoff([spot](const auto& payoff) { return payoff.payoff(spot); });
+}
+
 
 
@@ -0,0 +1,68 @@
+/*
+ * This file is licensed under the Mozilla Public License, v. 2.0.
+ * You can obtain a copy of the license at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "PathModels.h"
+
+#include <utility>		// std::move
+#include <algorithm>
+#include <functional>	// std::greater_equal
+#include <stdexcept>
+
+HestonModel::HestonModel(double v0, double kappa, double theta, double sigma, double rho) :
+	v0_{v0}, kappa_{kappa}, theta_{theta}, sigma_{sigma}, rho_{rho}
+{
+	if (v0_ < 0.0 || kappa_ <= 0.0 || theta_ <= 0.0 || sigma_ <= 0.0 || rho_ < -1.0 || rho_ > 1.0)
+	{
+		throw std::invalid_argument{"HestonModel: need v0 >= 0, kappa, theta, sigma > 0, "
+			"and -1 <= rho <= 1"};
+	}
+}
+
+SABRModel::SABRModel(double alpha0, double beta, double nu, double rho) :
+	alpha0_{alpha0}, beta_{beta}, nu_{nu}, rho_{rho}
+{
+	if (alpha0_ <= 0.0 || beta_ < 0.0 || beta_ > 1.0 || nu_ < 0.0 || rho_ < -1.0 || rho_ > 1.0)
+	{
+		throw std::invalid_argument{"SABRModel: need alpha0 > 0, 0 <= beta <= 1, nu >= 0, "
+			"and -1 <= rho <= 1"};
+	}
+}
+
+LocalVolModel::LocalVolModel(std::vector<double> times, std::vector<double> spots,
+	std::vector<double> vols) :
+	times_{std::move(times)}, spots_{std::move(spots)}, vols_{std::move(vols)}
+{
+	if (times_.empty() || spots_.empty() || vols_.size() != times_.size() * spots_.size())
+	{
+		throw std::invalid_argument{"LocalVolModel: need one vol per (time, spot) grid point"};
+	}
+	if (std::ranges::adjacent_find(times_, std::greater_equal<>{}) != times_.end()
+		|| std::ranges::adjacent_find(spots_, std::greater_equal<>{}) != spots_.end())
+	{
+		throw std::invalid_argument{"LocalVolModel: grid points must be increasing"};
+	}
+	if (std::ranges::any_of(vols_, [](double vol) {return vol < 0.0;}))
+	{
+		throw std::invalid_argument{"LocalVolModel: vols must be non-negative"};
+	}
+
+	// Interpolation needs two points in each direction, so a single time (vol
+	// constant in time) or spot level (vol constant in spot) is repeated:
+	if (spots_.size() == 1)
+	{
+		const double spot = spots_.front();
+		spots_ = {spot, spot};
+		std::vector<double> vols;
+		for (double vol : vols_) vols.insert(vols.end(), {vol, vol});
+		vols_ = std::move(vols);
+	}
+	if (times_.size() == 1)
+	{
+		const double time = times_.front();
+		times_ = {time, time};
+		const std::vector<double> first_row = vols_;
+		vols_.insert(vols_.end(), first_row.begin(), first_row.end());
+	}
+}
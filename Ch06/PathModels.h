@@ -0,0 +1,189 @@
+/*
+ * This file is licensed under the Mozilla Public License, v. 2.0.
+ * You can obtain a copy of the license at http://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#include "Philox.h"
+#include "NormalSamplers.h"
+
+#include <concepts>
+#include <vector>
+#include <random>
+#include <cmath>
+#include <algorithm>
+#include <cstddef>
+
+// Risk-neutral dynamics of an equity price, for Monte Carlo valuation with
+// MCOptionValuation::calc_price_with_model(.).  A model has a State (the spot
+// together with any other factors, eg the variance), created from the spot
+// by initial_state(.), and moved on from time t to t + dt by step(.), which
+// returns the new spot.  carry is the risk-neutral drift of the spot, r - q.
+//
+// The valuation is a template on the model, so step(.) is resolved at compile
+// time and can be inlined into the stepping loop: there is no virtual call
+// per step.  The step functions are therefore defined here, in the header.
+template<typename M>
+concept PathModel = requires(const M& model, typename M::State& state, Philox4x32& rng,
+	double spot, double t, double dt, double carry)
+{
+	{ model.initial_state(spot) } -> std::same_as<typename M::State>;
+	{ model.step(state, t, dt, carry, rng) } -> std::same_as<double>;
+};
+
+// Heston stochastic volatility,
+//		dS = (r - q) S dt + sqrt(v) S dW_1,
+//		dv = kappa (theta - v) dt + sigma sqrt(v) dW_2,		d<W_1, W_2> = rho dt,
+// stepped with Andersen's Quadratic-Exponential (QE) scheme, which samples the
+// variance from a moment-matched distribution, so that it stays non-negative
+// without the bias of a truncated Euler scheme, even for coarse time steps.
+class HestonModel
+{
+public:
+	struct State
+	{
+		double spot;
+		double variance;
+	};
+
+	HestonModel(double v0, double kappa, double theta, double sigma, double rho);
+
+	State initial_state(double spot) const { return State{spot, v0_}; }
+
+	double step(State& state, double /* t */, double dt, double carry, Philox4x32& rng) const
+	{
+		ZigguratNormal zn;
+		std::uniform_real_distribution<> ud;
+		const double v = state.variance;
+
+		// (1) Variance: the conditional mean m and variance s2 of v(t + dt), then
+		// a quadratic (psi <= psi_c) or exponential (psi > psi_c) sample matching them:
+		const double ekt = std::exp(-kappa_ * dt);
+		const double m = theta_ + (v - theta_) * ekt;
+		const double s2 = v * sigma_ * sigma_ * ekt * (1.0 - ekt) / kappa_
+			+ theta_ * sigma_ * sigma_ * (1.0 - ekt) * (1.0 - ekt) / (2.0 * kappa_);
+		const double psi = s2 / (m * m);
+
+		double v_next;
+		if (psi <= psi_c)
+		{
+			const double b2 = 2.0 / psi - 1.0 + std::sqrt(2.0 / psi) * std::sqrt(2.0 / psi - 1.0);
+			const double a = m / (1.0 + b2);
+			const double b_plus_z = std::sqrt(b2) + zn(rng);
+			v_next = a * b_plus_z * b_plus_z;
+		}
+		else
+		{
+			const double p = (psi - 1.0) / (psi + 1.0);
+			const double beta = (1.0 - p) / m;
+			const double u = ud(rng);
+			v_next = u <= p ? 0.0 : std::log((1.0 - p) / (1.0 - u)) / beta;
+		}
+
+		// (2) Log price, with the integrated variance approximated by the
+		// average of its values at each end of the step (gamma_1 = gamma_2 = 1/2):
+		const double k0 = -rho_ * kappa_ * theta_ / sigma_ * dt;
+		const double k1 = 0.5 * dt * (kappa_ * rho_ / sigma_ - 0.5) - rho_ / sigma_;
+		const double k2 = 0.5 * dt * (kappa_ * rho_ / sigma_ - 0.5) + rho_ / sigma_;
+		const double k3 = 0.5 * dt * (1.0 - rho_ * rho_);
+
+		state.spot *= std::exp(carry * dt + k0 + k1 * v + k2 * v_next
+			+ std::sqrt(k3 * (v + v_next)) * zn(rng));
+		state.variance = v_next;
+		return state.spot;
+	}
+
+private:
+	double v0_, kappa_, theta_, sigma_, rho_;
+	static constexpr double psi_c = 1.5;		// Switching level suggested by Andersen
+};
+
+// SABR,
+//		dS = (r - q) S dt + alpha S^beta dW_1,
+//		d alpha = nu alpha dW_2,		d<W_1, W_2> = rho dt,
+// stepped with the volatility alpha sampled exactly (it is lognormal) and the
+// spot by a log-Euler step with the local lognormal volatility alpha S^(beta - 1),
+// which keeps it positive.
+class SABRModel
+{
+public:
+	struct State
+	{
+		double spot;
+		double alpha;
+	};
+
+	SABRModel(double alpha0, double beta, double nu, double rho);
+
+	State initial_state(double spot) const { return State{spot, alpha0_}; }
+
+	double step(State& state, double /* t */, double dt, double carry, Philox4x32& rng) const
+	{
+		ZigguratNormal zn;
+		const double z1 = zn(rng);
+		const double z2 = rho_ * z1 + std::sqrt(1.0 - rho_ * rho_) * zn(rng);
+
+		const double sqrt_dt = std::sqrt(dt);
+		const double lognormal_vol = state.alpha * std::pow(state.spot, beta_ - 1.0);
+		state.spot *= std::exp((carry - 0.5 * lognormal_vol * lognormal_vol) * dt
+			+ lognormal_vol * sqrt_dt * z1);
+		state.alpha *= std::exp(nu_ * sqrt_dt * z2 - 0.5 * nu_ * nu_ * dt);
+		return state.spot;
+	}
+
+private:
+	double alpha0_, beta_, nu_, rho_;
+};
+
+// Local volatility sigma(t, S), given on a grid of times and spot levels
+// (vols[i * spots.size() + j] at times[i] and spots[j]), interpolated
+// bilinearly between grid points and held flat beyond the grid.  Log-Euler
+// steps use the volatility at the start of each step.
+class LocalVolModel
+{
+public:
+	struct State
+	{
+		double spot;
+	};
+
+	LocalVolModel(std::vector<double> times, std::vector<double> spots, std::vector<double> vols);
+
+	State initial_state(double spot) const { return State{spot}; }
+
+	double step(State& state, double t, double dt, double carry, Philox4x32& rng) const
+	{
+		ZigguratNormal zn;
+		const double vol = local_vol(t, state.spot);
+		state.spot *= std::exp((carry - 0.5 * vol * vol) * dt + vol * std::sqrt(dt) * zn(rng));
+		return state.spot;
+	}
+
+	double local_vol(double t, double spot) const
+	{
+		auto [i, wt] = locate_(times_, t);
+		auto [j, ws] = locate_(spots_, spot);
+		auto vol = [this](std::size_t i, std::size_t j) {return vols_[i * spots_.size() + j];};
+
+		const double lower = (1.0 - ws) * vol(i, j) + ws * vol(i, j + 1);
+		const double upper = (1.0 - ws) * vol(i + 1, j) + ws * vol(i + 1, j + 1);
+		return (1.0 - wt) * lower + wt * upper;
+	}
+
+private:
+	std::vector<double> times_, spots_, vols_;
+
+	// Index i of the grid interval [grid[i], grid[i + 1]] containing x, and the
+	// weight of grid[i + 1] in the interpolation (0 or 1 beyond the ends).  A
+	// grid of one point has a zero-width interval, repeated by the constructor:
+	static std::pair<std::size_t, double> locate_(const std::vector<double>& grid, double x)
+	{
+		if (x <= grid.front()) return {0, 0.0};
+		if (x >= grid.back()) return {grid.size() - 2, 1.0};
+
+		const auto upper = std::ranges::upper_bound(grid, x);
+		const std::size_t i = static_cast<std::size_t>(upper - grid.begin()) - 1;
+		return {i, (x - grid[i]) / (grid[i + 1] - grid[i])};
+	}
+};
@@ -0,0 +1,53 @@
+/*
+ * This file is licensed under the Mozilla Public License, v. 2.0.
+ * You can obtain a copy of the license at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "PathPayoffs.h"
+#include <stdexcept>
+
+AsianOption::AsianOption(PayoffType payoff_type, double strike, AsianAverage average) :
+	payoff_type_{payoff_type}, phi_{static_cast<double>(static_cast<int>(payoff_type))},
+	strike_{strike}, average_{average}
+{
+	if (strike <= 0.0)
+	{
+		throw std::invalid_argument{"AsianOption: the strike must be positive"};
+	}
+}
+
+double AsianOption::control_price(double spot, double time_to_exp, int time_steps, double vol,
+	double int_rate, double div_rate) const
+{
+	// With t_i = i dt, log G = (1/n) sum log S(t_i) is normal, with mean and variance
+	//		mu = log S(0) + (r - q - vol^2/2) dt (n + 1)/2,
+	//		v  = vol^2 dt (n + 1)(2n + 1)/(6n).
+	// Its price is then Black-Scholes with the same expiration, a vol of
+	// sqrt(v/T), and a dividend yield that sets the forward to E[G] = exp(mu + v/2):
+	const double n = time_steps;
+	const double dt = time_to_exp / n;
+	const double mu = std::log(spot) + (int_rate - div_rate - 0.5 * vol * vol) * dt * (n + 1.0) / 2.0;
+	const double v = vol * vol * dt * (n + 1.0) * (2.0 * n + 1.0) / (6.0 * n);
+	const double adj_div = int_rate - (mu + 0.5 * v - std::log(spot)) / time_to_exp;
+
+	BlackScholes bsc{strike_, spot, time_to_exp, payoff_type_, int_rate, adj_div};
+	return bsc(std::sqrt(v / time_to_exp));
+}
+
+LookbackOption::LookbackOption(PayoffType payoff_type, LookbackStrike strike_type, double strike) :
+	payoff_type_{payoff_type}, strike_type_{strike_type}, strike_{strike}
+{
+	if (strike_type == LookbackStrike::fixed && strike <= 0.0)
+	{
+		throw std::invalid_argument{"LookbackOption: a fixed strike must be positive"};
+	}
+}
+
+RangeAccrual::RangeAccrual(double lower, double upper, double notional) :
+	lower_{lower}, upper_{upper}, notional_{notional}
+{
+	if (lower > upper)
+	{
+		throw std::invalid_argument{"RangeAccrual: lower must not be above upper"};
+	}
+}
@@ -0,0 +1,179 @@
+/*
+ * This file is licensed under the Mozilla Public License, v. 2.0.
+ * You can obtain a copy of the license at http://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#include "BlackScholes.h"		// PayoffType
+
+#include <concepts>
+#include <algorithm>
+#include <cmath>
+
+// Path-functional payoffs, for MCOptionValuation::calc_price_path_functional(.).
+// Rather than storing each scenario and applying a payoff to it, a path
+// functional keeps a small accumulator per path (a running average, extreme,
+// or count) in its State, created from the spot by initial_state(.), and
+// updated by update(.) with the price at each time step t_1, ..., t_n = T as
+// the path is generated.  payoff(.) is then a function of the final State
+// alone, so a path needs O(1) memory, whatever the number of time steps.
+//
+// As with PathModel, the valuation is a template on the payoff, so update(.)
+// is inlined into the stepping loop, and is defined here, in the header.
+template<typename F>
+concept PathFunctional = std::copy_constructible<F> && requires(const F& functional,
+	typename F::State& state, double price)
+{
+	{ functional.initial_state(price) } -> std::same_as<typename F::State>;
+	functional.update(state, price);
+	{ functional.payoff(state) } -> std::convertible_to<double>;
+};
+
+// A path functional may also carry a control variate: control(.) is a second
+// payoff computed from the same State, whose discounted expectation under
+// geometric Brownian motion is known in closed form, as control_price(.):
+template<typename F>
+concept PathFunctionalWithControl = PathFunctional<F> && requires(const F& functional,
+	const typename F::State& state, double x, int time_steps)
+{
+	{ functional.control(state) } -> std::convertible_to<double>;
+	{ functional.control_price(x, x, time_steps, x, x, x) } -> std::convertible_to<double>;
+};
+
+enum class AsianAverage
+{
+	arithmetic,
+	geometric
+};
+
+// Fixed-strike Asian option on the average of the prices at the time steps
+// (not including the spot): max(A - K, 0) for a call, max(K - A, 0) for a put.
+// The arithmetic average has no closed-form price, but the geometric average
+// of the same prices is lognormal, and so the geometric Asian (Kemna and Vorst)
+// serves as the control variate; the two are very highly correlated.  For a
+// geometric Asian, the payoff is its own control, and the valuation returns
+// the closed-form price:
+class AsianOption
+{
+public:
+	struct State
+	{
+		double sum{0.0};		// Sum of the prices
+		double log_sum{0.0};	// Sum of their logs
+		int count{0};
+	};
+
+	AsianOption(PayoffType payoff_type, double strike,
+		AsianAverage average = AsianAverage::arithmetic);
+
+	State initial_state(double /* spot */) const { return State{}; }
+
+	void update(State& state, double price) const
+	{
+		state.sum += price;
+		state.log_sum += std::log(price);
+		++state.count;
+	}
+
+	double payoff(const State& state) const
+	{
+		const double avg = average_ == AsianAverage::arithmetic ? state.sum / state.count
+			: std::exp(state.log_sum / state.count);
+		return std::max(phi_ * (avg - strike_), 0.0);
+	}
+
+	double control(const State& state) const
+	{
+		return std::max(phi_ * (std::exp(state.log_sum / state.count) - strike_), 0.0);
+	}
+
+	// Discounted price of the geometric Asian, averaging at time_steps equally
+	// spaced dates:
+	double control_price(double spot, double time_to_exp, int time_steps, double vol,
+		double int_rate, double div_rate) const;
+
+private:
+	PayoffType payoff_type_;
+	double phi_;			// +1: call, -1: put
+	double strike_;
+	AsianAverage average_;
+};
+
+enum class LookbackStrike
+{
+	fixed,			// Call max(M - K, 0), put max(K - m, 0)
+	floating		// Call S(T) - m, put M - S(T)
+};
+
+// Lookback option on the maximum M and minimum m of the prices at the time
+// steps, including the spot.  The extremes are monitored discretely, so they
+// understate those of a continuously monitored lookback, by an amount that
+// shrinks with the time step:
+class LookbackOption
+{
+public:
+	struct State
+	{
+		double min;
+		double max;
+		double last;
+	};
+
+	LookbackOption(PayoffType payoff_type, LookbackStrike strike_type, double strike = 0.0);
+
+	State initial_state(double spot) const { return State{spot, spot, spot}; }
+
+	void update(State& state, double price) const
+	{
+		state.min = std::min(state.min, price);
+		state.max = std::max(state.max, price);
+		state.last = price;
+	}
+
+	double payoff(const State& state) const
+	{
+		const bool call = payoff_type_ == PayoffType::Call;
+		if (strike_type_ == LookbackStrike::fixed)
+		{
+			return call ? std::max(state.max - strike_, 0.0) : std::max(strike_ - state.min, 0.0);
+		}
+		return call ? state.last - state.min : state.max - state.last;
+	}
+
+private:
+	PayoffType payoff_type_;
+	LookbackStrike strike_type_;
+	double strike_;
+};
+
+// Range accrual: pays the notional times the fraction of the time steps at
+// which the price is within [lower, upper]:
+class RangeAccrual
+{
+public:
+	struct State
+	{
+		int in_range{0};
+		int count{0};
+	};
+
+	RangeAccrual(double lower, double upper, double notional = 1.0);
+
+	State initial_state(double /* spot */) const { return State{}; }
+
+	void update(State& state, double price) const
+	{
+		state.in_range += (price >= lower_ && price <= upper_) ? 1 : 0;
+		++state.count;
+	}
+
+	double payoff(const State& state) const
+	{
+		return notional_ * state.in_range / state.count;
+	}
+
+private:
+	double lower_, upper_;
+	double notional_;
+};
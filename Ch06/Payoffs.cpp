@@ -5,19 +5,22 @@
 
 #include "Payoffs.h"
 #include <algorithm>
+#include <cmath>
 
 
 // The following implementations (from ch 3) are used to demonstrate 
 // the modern (C++11/C++14) method of implementing RAII for option payoffs.
 
-// --- CallPayoff implementation ---
-CallPayoff::CallPayoff(double strike) :strike_{strike} {}
-
-double CallPayoff::payoff(double spot) const
+double Payoff::payoff_derivative(double price) const
 {
-	return std::max(spot - strike_, 0.0);
+	const double h = 1e-6 * std::max(std::abs(price), 1.0);
+	return (payoff(price + h) - payoff(price - h)) / (2.0 * h);
 }
 
+// --- CallPayoff implementation ---
+// payoff(.) and payoff_derivative(.) are defined inline in Payoffs.h.
+CallPayoff::CallPayoff(double strike) :strike_{strike} {}
+
 std::unique_ptr<Payoff> CallPayoff::clone() const
 {
 	return std::make_unique<CallPayoff>(*this);
@@ -27,12 +30,16 @@ std::unique_ptr<Payoff> CallPayoff::clone() const
 // --- PutPayoff implementation ---
 PutPayoff::PutPayoff(double strike) :strike_{strike} {}
 
-double PutPayoff::payoff(double spot) const
+std::unique_ptr<Payoff> PutPayoff::clone() const
 {
-	return std::max(strike_ - spot, 0.0);
+	return std::make_unique<PutPayoff>(*this);
 }
 
-std::unique_ptr<Payoff> PutPayoff::clone() const
+
+// --- DigitalPayoff implementation ---
+DigitalPayoff::DigitalPayoff(double strike, double cash) :strike_{strike}, cash_{cash} {}
+
+std::unique_ptr<Payoff> DigitalPayoff::clone() const
 {
-	return std::make_unique<PutPayoff>(*this);
+	return std::make_unique<DigitalPayoff>(*this);
 }
\ No newline at end of file
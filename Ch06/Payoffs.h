@@ -5,22 +5,46 @@
 
 #pragma once
 #include <memory>
+#include <algorithm>
 
 // Payoff (C++11/C++14) -- from Ch 3
 
+// Whether a payoff depends only on the underlying price at expiration,
+// or on the path taken to get there.  A Monte Carlo engine can sample
+// the terminal price directly in the first case.
+enum class PathDependence
+{
+	terminal_only,
+	path_dependent
+};
+
 class Payoff
 {
 public:
 	virtual double payoff(double price) const = 0;
 	virtual std::unique_ptr<Payoff> clone() const = 0;	
+	virtual PathDependence path_dependence() const { return PathDependence::terminal_only; }
+
+	// Whether the payoff is continuous in the price, so that its derivative
+	// gives a pathwise sensitivity:
+	virtual bool is_continuous() const { return true; }
+
+	// d payoff / d price, for pathwise sensitivities.  The default is a central
+	// difference; payoffs with a closed form derivative override it:
+	virtual double payoff_derivative(double price) const;
 	virtual ~Payoff() = default;
 };
 
+// The payoff(.) functions of the final classes below are defined inline, so
+// that a call through an object of the derived type (eg, when OptionInfo
+// dispatches with std::visit) is not virtual and can be inlined into a loop.
+
 class CallPayoff final : public Payoff
 {
 public:
 	CallPayoff(double strike);
 	double payoff(double price) const override;
+	double payoff_derivative(double price) const override;
 	std::unique_ptr<Payoff> clone() const override;		// clone() now returns a unique_ptr<Payoff>,
 														// not unique_ptr<CallPayoff>
 
@@ -28,15 +52,58 @@ private:
 	double strike_;
 };
 
+inline double CallPayoff::payoff(double price) const
+{
+	return std::max(price - strike_, 0.0);
+}
+
+inline double CallPayoff::payoff_derivative(double price) const
+{
+	return price > strike_ ? 1.0 : 0.0;
+}
+
 class PutPayoff final : public Payoff
 {
 public:
 	PutPayoff(double strike);
 	//double operator()(double spot) const override;
 	double payoff(double price) const override;
+	double payoff_derivative(double price) const override;
 	std::unique_ptr<Payoff> clone() const override;		// clone() now returns a unique_ptr<Payoff>,
 														// not unique_ptr<PutPayoff>
 
 private:
 	double strike_;
 };
+
+inline double PutPayoff::payoff(double price) const
+{
+	return std::max(strike_ - price, 0.0);
+}
+
+inline double PutPayoff::payoff_derivative(double price) const
+{
+	return price < strike_ ? -1.0 : 0.0;
+}
+
+// Cash-or-nothing call: pays cash if the price is above the strike at
+// expiration.  Its derivative is zero wherever it is defined, so a pathwise
+// delta estimate is also zero, and MCOptionValuation::calc_price_and_greeks(.)
+// rejects it; reprice with bumped inputs instead.
+class DigitalPayoff final : public Payoff
+{
+public:
+	DigitalPayoff(double strike, double cash = 1.0);
+	double payoff(double price) const override;
+	bool is_continuous() const override { return false; }
+	std::unique_ptr<Payoff> clone() const override;
+
+private:
+	double strike_;
+	double cash_;
+};
+
+inline double DigitalPayoff::payoff(double price) const
+{
+	return price > strike_ ? cash_ : 0.0;
+}
@@ -0,0 +1,162 @@
+/*
+ * This file is licensed under the Mozilla Public License, v. 2.0.
+ * You can obtain a copy of the license at http://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#include <array>
+#include <span>
+#include <algorithm>	// std::min
+#include <cstdint>
+#include <limits>
+#include <cstddef>
+
+// Philox4x32-10 counter-based random number generator (Salmon et al, "Parallel
+// Random Numbers: As Easy as 1, 2, 3", SC11).  Each output block is a keyed
+// bijection of a 128-bit counter, so there is no state to warm up: the stream
+// for (seed, stream_id) starts at counter {0, 0, stream_id}, and constructing
+// it costs nothing.  Monte Carlo path i can then use Philox4x32{seed, i}, which
+// depends only on the seed and i -- not on which thread simulates it, or on
+// how many draws were made before it.
+//
+// Satisfies std::uniform_random_bit_generator, with 64-bit results (two per
+// 128-bit block), so it can be used with the <random> distributions.
+class Philox4x32
+{
+public:
+	using result_type = std::uint64_t;
+
+	Philox4x32(std::uint64_t seed, std::uint64_t stream_id) :
+		key_{static_cast<std::uint32_t>(seed), static_cast<std::uint32_t>(seed >> 32)},
+		counter_{0, 0, static_cast<std::uint32_t>(stream_id),
+			static_cast<std::uint32_t>(stream_id >> 32)} {}
+
+	static constexpr result_type min() { return 0; }
+	static constexpr result_type max() { return std::numeric_limits<result_type>::max(); }
+
+	result_type operator()()
+	{
+		if (next_ == 2)
+		{
+			block_ = generate_block(counter_, key_);
+			increment_counter_();
+			next_ = 0;
+		}
+
+		const std::size_t i = 2 * next_++;
+		return (static_cast<std::uint64_t>(block_[i + 1]) << 32) | block_[i];
+	}
+
+	// The next out.size() results, as from as many calls of operator()(.).  The
+	// whole blocks among them are generated together, a round at a time over
+	// a run of counters, in a loop that the compiler can vectorize:
+	void fill(std::span<result_type> out)
+	{
+		std::size_t n = 0;
+		while (n < out.size() && next_ != 2) out[n++] = (*this)();
+
+		constexpr std::size_t run = 32;			// Blocks generated together
+		std::array<std::uint32_t, run> ctr_0, ctr_1, ctr_2, ctr_3;
+		while (out.size() - n >= 2)
+		{
+			const std::size_t num_blocks = std::min(run, (out.size() - n) / 2);
+			const std::uint64_t low = (static_cast<std::uint64_t>(counter_[1]) << 32) | counter_[0];
+			for (std::size_t j = 0; j < run; ++j)
+			{
+				ctr_0[j] = static_cast<std::uint32_t>(low + j);
+				ctr_1[j] = static_cast<std::uint32_t>((low + j) >> 32);
+				ctr_2[j] = counter_[2];
+				ctr_3[j] = counter_[3];
+			}
+
+			std::array<std::uint32_t, 2> key = key_;
+			for (int round = 0; round < 10; ++round)
+			{
+				for (std::size_t j = 0; j < run; ++j)
+				{
+					const std::uint64_t prod_0 = static_cast<std::uint64_t>(mult_0) * ctr_0[j];
+					const std::uint64_t prod_1 = static_cast<std::uint64_t>(mult_1) * ctr_2[j];
+					ctr_0[j] = static_cast<std::uint32_t>(prod_1 >> 32) ^ ctr_1[j] ^ key[0];
+					ctr_1[j] = static_cast<std::uint32_t>(prod_1);
+					ctr_2[j] = static_cast<std::uint32_t>(prod_0 >> 32) ^ ctr_3[j] ^ key[1];
+					ctr_3[j] = static_cast<std::uint32_t>(prod_0);
+				}
+				key[0] += weyl_0;
+				key[1] += weyl_1;
+			}
+
+			for (std::size_t j = 0; j < num_blocks; ++j)
+			{
+				out[n + 2 * j] = (static_cast<std::uint64_t>(ctr_1[j]) << 32) | ctr_0[j];
+				out[n + 2 * j + 1] = (static_cast<std::uint64_t>(ctr_3[j]) << 32) | ctr_2[j];
+			}
+			advance_counter_(num_blocks);
+			n += 2 * num_blocks;
+		}
+
+		if (n < out.size()) out[n] = (*this)();
+	}
+
+	// Skips z results, in constant time:
+	void discard(unsigned long long z)
+	{
+		const unsigned long long buffered = 2 - next_;
+		if (z < buffered)
+		{
+			next_ += static_cast<unsigned>(z);
+			return;
+		}
+
+		z -= buffered;
+		advance_counter_(z / 2);
+		next_ = 2;
+		if (z % 2 != 0)
+		{
+			(*this)();
+		}
+	}
+
+	// The raw block function, exposed for known-answer tests:
+	static std::array<std::uint32_t, 4> generate_block(std::array<std::uint32_t, 4> ctr,
+		std::array<std::uint32_t, 2> key)
+	{
+		for (int round = 0; round < 10; ++round)
+		{
+			const std::uint64_t prod_0 = static_cast<std::uint64_t>(mult_0) * ctr[0];
+			const std::uint64_t prod_1 = static_cast<std::uint64_t>(mult_1) * ctr[2];
+
+			ctr = {static_cast<std::uint32_t>(prod_1 >> 32) ^ ctr[1] ^ key[0],
+				static_cast<std::uint32_t>(prod_1),
+				static_cast<std::uint32_t>(prod_0 >> 32) ^ ctr[3] ^ key[1],
+				static_cast<std::uint32_t>(prod_0)};
+
+			key[0] += weyl_0;
+			key[1] += weyl_1;
+		}
+
+		return ctr;
+	}
+
+private:
+	static constexpr std::uint32_t mult_0 = 0xD2511F53, mult_1 = 0xCD9E8D57;
+	static constexpr std::uint32_t weyl_0 = 0x9E3779B9, weyl_1 = 0xBB67AE85;
+
+	void increment_counter_()
+	{
+		if (++counter_[0] == 0) ++counter_[1];
+	}
+
+	void advance_counter_(std::uint64_t n)
+	{
+		std::uint64_t low = (static_cast<std::uint64_t>(counter_[1]) << 32) | counter_[0];
+		low += n;
+		counter_[0] = static_cast<std::uint32_t>(low);
+		counter_[1] = static_cast<std::uint32_t>(low >> 32);
+	}
+
+	std::array<std::uint32_t, 2> key_;
+	std::array<std::uint32_t, 4> counter_;		// {block (low, high), stream_id (low, high)}
+	std::array<std::uint32_t, 4> block_{};
+	unsigned next_{2};							// Next 64-bit result in block_ (2: empty)
+};
@@ -0,0 +1,115 @@
+/*
+ * This file is licensed under the Mozilla Public License, v. 2.0.
+ * You can obtain a copy of the license at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "RunningStats.h"
+#include <cmath>
+
+RunningStats::RunningStats(const State& state) :
+	count_{state.count}, mean_{state.mean}, m2_{state.m2} {}
+
+RunningStats::State RunningStats::state() const
+{
+	return State{count_, mean_, m2_};
+}
+
+void RunningStats::add(double x)
+{
+	++count_;
+	double delta = x - mean_;
+	mean_ += delta / count_;
+	m2_ += delta * (x - mean_);
+}
+
+void RunningStats::merge(const RunningStats& other)
+{
+	if (other.count_ == 0) return;
+	if (count_ == 0)
+	{
+		*this = other;
+		return;
+	}
+
+	const double n_a = static_cast<double>(count_);
+	const double n_b = static_cast<double>(other.count_);
+	const double n = n_a + n_b;
+	const double delta = other.mean_ - mean_;
+
+	mean_ += delta * n_b / n;
+	m2_ += other.m2_ + delta * delta * n_a * n_b / n;
+	count_ += other.count_;
+}
+
+std::uint64_t RunningStats::count() const
+{
+	return count_;
+}
+
+double RunningStats::mean() const
+{
+	return mean_;
+}
+
+double RunningStats::variance() const
+{
+	return count_ > 1 ? m2_ / (count_ - 1) : 0.0;
+}
+
+double RunningStats::std_error() const
+{
+	return count_ > 1 ? std::sqrt(variance() / count_) : 0.0;
+}
+
+RunningCovariance::RunningCovariance(const State& state) :
+	x_{state.x}, y_{state.y}, c2_{state.c2} {}
+
+RunningCovariance::State RunningCovariance::state() const
+{
+	return State{x_.state(), y_.state(), c2_};
+}
+
+void RunningCovariance::add(double x, double y)
+{
+	const double dx = x - x_.mean();	// Deviation from the previous mean of x...
+	x_.add(x);
+	y_.add(y);
+	c2_ += dx * (y - y_.mean());		// ...times the deviation from the updated mean of y
+}
+
+void RunningCovariance::merge(const RunningCovariance& other)
+{
+	if (other.count() == 0) return;
+	if (count() == 0)
+	{
+		*this = other;
+		return;
+	}
+
+	const double n_a = static_cast<double>(count());
+	const double n_b = static_cast<double>(other.count());
+	c2_ += other.c2_ + (other.x_.mean() - x_.mean()) * (other.y_.mean() - y_.mean())
+		* n_a * n_b / (n_a + n_b);
+	x_.merge(other.x_);
+	y_.merge(other.y_);
+}
+
+std::uint64_t RunningCovariance::count() const
+{
+	return y_.count();
+}
+
+const RunningStats& RunningCovariance::x() const
+{
+	return x_;
+}
+
+const RunningStats& RunningCovariance::y() const
+{
+	return y_;
+}
+
+double RunningCovariance::covariance() const
+{
+	return count() > 1 ? c2_ / (count() - 1) : 0.0;
+}
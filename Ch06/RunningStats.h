@@ -0,0 +1,71 @@
+/*
+ * This file is licensed under the Mozilla Public License, v. 2.0.
+ * You can obtain a copy of the license at http://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#include <cstdint>
+
+// Streaming mean and variance of a sequence of samples, using Welford's
+// update, so that memory stays constant in the number of samples.
+// Two sets of statistics (eg, from separate threads) can be combined
+// with merge(.), using the pairwise update of Chan, Golub, and LeVeque.
+class RunningStats
+{
+public:
+	// The raw state, so that the statistics can be saved (eg, to a file) and
+	// restored exactly:
+	struct State
+	{
+		std::uint64_t count{0};
+		double mean{0.0};
+		double m2{0.0};
+	};
+
+	RunningStats() = default;
+	explicit RunningStats(const State& state);
+	State state() const;
+
+	void add(double x);
+	void merge(const RunningStats& other);
+
+	std::uint64_t count() const;
+	double mean() const;
+	double variance() const;		// Unbiased sample variance
+	double std_error() const;		// Standard error of the mean
+
+private:
+	std::uint64_t count_{0};
+	double mean_{0.0};
+	double m2_{0.0};				// Sum of squared deviations from the mean
+};
+
+// Streaming means, variances, and covariance of pairs of samples (x, y),
+// mergeable in the same way.  The y statistics are exactly those a
+// RunningStats would give for y alone.
+class RunningCovariance
+{
+public:
+	struct State
+	{
+		RunningStats::State x, y;
+		double c2{0.0};
+	};
+
+	RunningCovariance() = default;
+	explicit RunningCovariance(const State& state);
+	State state() const;
+
+	void add(double x, double y);
+	void merge(const RunningCovariance& other);
+
+	std::uint64_t count() const;
+	const RunningStats& x() const;
+	const RunningStats& y() const;
+	double covariance() const;		// Unbiased sample covariance
+
+private:
+	RunningStats x_, y_;
+	double c2_{0.0};				// Sum of products of deviations from the means
+};
@@ -0,0 +1,238 @@
+/*
+ * This file is licensed under the Mozilla Public License, v. 2.0.
+ * You can obtain a copy of the license at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "ScenarioStore.h"
+#include "EquityPriceGenerator.h"
+#include "Philox.h"
+
+#include <fstream>
+#include <vector>
+#include <algorithm>
+#include <cstring>		// std::memcpy, std::memcmp
+#include <utility>		// std::exchange
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+	constexpr char scenario_magic[8] = {'M', 'C', 'S', 'C', 'E', 'N', 'A', 'R'};
+	constexpr std::uint32_t scenario_version = 1;
+
+	// Paths generated, transposed, and written together:
+	constexpr std::size_t paths_per_write = 4096;
+
+	std::size_t value_size(ScenarioValueType value_type)
+	{
+		return value_type == ScenarioValueType::float64 ? sizeof(double) : sizeof(float);
+	}
+
+	template<typename T>
+	void write_prices(std::ofstream& file, const EquityPriceGenerator& epg,
+		std::uint64_t num_scenarios, std::size_t num_time_steps, std::uint64_t seed)
+	{
+		std::vector<double> path(num_time_steps + 1);
+		std::vector<T> block(paths_per_write * num_time_steps);		// Step-major
+
+		for (std::uint64_t first = 0; first < num_scenarios; first += paths_per_write)
+		{
+			const std::size_t count = static_cast<std::size_t>(
+				std::min<std::uint64_t>(paths_per_write, num_scenarios - first));
+			for (std::size_t i = 0; i < count; ++i)
+			{
+				Philox4x32 rng{seed, first + i};
+				epg(rng, path);
+				for (std::size_t k = 0; k < num_time_steps; ++k)
+				{
+					block[k * paths_per_write + i] = static_cast<T>(path[k + 1]);
+				}
+			}
+
+			// The block's segment of each column:
+			for (std::size_t k = 0; k < num_time_steps; ++k)
+			{
+				file.seekp(sizeof(ScenarioHeader) + (k * num_scenarios + first) * sizeof(T));
+				file.write(reinterpret_cast<const char*>(block.data() + k * paths_per_write),
+					count * sizeof(T));
+			}
+		}
+	}
+}
+
+void write_scenario_file(const std::filesystem::path& file_name, double spot,
+	int num_time_steps, double time_to_expiration, double volatility, double rf_rate,
+	double div_rate, std::uint64_t num_scenarios, std::uint64_t seed,
+	ScenarioValueType value_type)
+{
+	if (num_time_steps < 1 || num_scenarios < 1)
+	{
+		throw std::invalid_argument{"write_scenario_file: no scenarios to write"};
+	}
+
+	ScenarioHeader header{};
+	std::memcpy(header.magic, scenario_magic, sizeof(header.magic));
+	header.version = scenario_version;
+	header.value_type = value_type;
+	header.num_scenarios = num_scenarios;
+	header.num_time_steps = static_cast<std::uint64_t>(num_time_steps);
+	header.seed = seed;
+	header.spot = spot;
+	header.time_to_expiration = time_to_expiration;
+	header.volatility = volatility;
+	header.rf_rate = rf_rate;
+	header.div_rate = div_rate;
+
+	std::ofstream file{file_name, std::ios::binary | std::ios::trunc};
+	if (!file)
+	{
+		throw std::runtime_error{"write_scenario_file: cannot open " + file_name.string()};
+	}
+	file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+	EquityPriceGenerator epg{spot, num_time_steps, time_to_expiration, volatility,
+		rf_rate, div_rate};
+	const std::size_t steps = static_cast<std::size_t>(num_time_steps);
+	if (value_type == ScenarioValueType::float64)
+	{
+		write_prices<double>(file, epg, num_scenarios, steps, seed);
+	}
+	else
+	{
+		write_prices<float>(file, epg, num_scenarios, steps, seed);
+	}
+
+	file.close();
+	if (!file)
+	{
+		throw std::runtime_error{"write_scenario_file: error writing " + file_name.string()};
+	}
+}
+
+ScenarioFile::ScenarioFile(const std::filesystem::path& file_name)
+{
+	const std::string name = file_name.string();
+
+#ifdef _WIN32
+	HANDLE file = CreateFileW(file_name.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+		OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		throw std::runtime_error{"ScenarioFile: cannot open " + name};
+	}
+
+	LARGE_INTEGER file_size{};
+	HANDLE mapping = nullptr;
+	if (GetFileSizeEx(file, &file_size) && file_size.QuadPart > 0)
+	{
+		mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	}
+	CloseHandle(file);
+	if (mapping == nullptr)
+	{
+		throw std::runtime_error{"ScenarioFile: cannot map " + name};
+	}
+
+	// The view keeps the mapping alive after its handle is closed:
+	void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	CloseHandle(mapping);
+	if (view == nullptr)
+	{
+		throw std::runtime_error{"ScenarioFile: cannot map " + name};
+	}
+	data_ = static_cast<const std::byte*>(view);
+	size_ = static_cast<std::size_t>(file_size.QuadPart);
+#else
+	const int fd = ::open(name.c_str(), O_RDONLY);
+	if (fd < 0)
+	{
+		throw std::runtime_error{"ScenarioFile: cannot open " + name};
+	}
+
+	struct stat file_stat{};
+	void* view = MAP_FAILED;
+	if (::fstat(fd, &file_stat) == 0 && file_stat.st_size > 0)
+	{
+		view = ::mmap(nullptr, static_cast<std::size_t>(file_stat.st_size), PROT_READ,
+			MAP_SHARED, fd, 0);
+	}
+	::close(fd);		// The mapping stays valid
+	if (view == MAP_FAILED)
+	{
+		throw std::runtime_error{"ScenarioFile: cannot map " + name};
+	}
+	data_ = static_cast<const std::byte*>(view);
+	size_ = static_cast<std::size_t>(file_stat.st_size);
+#endif
+
+	// Check the header, and that the file holds exactly the prices it describes:
+	bool valid = size_ > sizeof(ScenarioHeader);
+	if (valid)
+	{
+		const ScenarioHeader& hdr = header();
+		const std::size_t payload = size_ - sizeof(ScenarioHeader);
+		valid = std::memcmp(hdr.magic, scenario_magic, sizeof(hdr.magic)) == 0
+			&& hdr.version == scenario_version
+			&& (hdr.value_type == ScenarioValueType::float64
+				|| hdr.value_type == ScenarioValueType::float32)
+			&& hdr.num_time_steps > 0 && hdr.num_time_steps <= payload;
+		if (valid)
+		{
+			const std::size_t row_bytes = value_size(hdr.value_type) * hdr.num_time_steps;
+			valid = payload % row_bytes == 0 && hdr.num_scenarios == payload / row_bytes;
+		}
+	}
+
+	if (!valid)
+	{
+		unmap_();
+		throw std::runtime_error{"ScenarioFile: " + name + " is not a valid scenario file"};
+	}
+}
+
+ScenarioFile::~ScenarioFile()
+{
+	unmap_();
+}
+
+ScenarioFile::ScenarioFile(ScenarioFile&& rhs) noexcept :
+	data_{std::exchange(rhs.data_, nullptr)}, size_{std::exchange(rhs.size_, 0)} {}
+
+ScenarioFile& ScenarioFile::operator =(ScenarioFile&& rhs) noexcept
+{
+	if (this != &rhs)
+	{
+		unmap_();
+		data_ = std::exchange(rhs.data_, nullptr);
+		size_ = std::exchange(rhs.size_, 0);
+	}
+	return *this;
+}
+
+const ScenarioHeader& ScenarioFile::header() const
+{
+	return *reinterpret_cast<const ScenarioHeader*>(data_);
+}
+
+void ScenarioFile::unmap_() noexcept
+{
+	if (data_ == nullptr) return;
+
+#ifdef _WIN32
+	UnmapViewOfFile(data_);
+#else
+	::munmap(const_cast<std::byte*>(data_), size_);
+#endif
+	data_ = nullptr;
+	size_ = 0;
+}
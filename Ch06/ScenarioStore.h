@@ -0,0 +1,113 @@
+/*
+ * This file is licensed under the Mozilla Public License, v. 2.0.
+ * You can obtain a copy of the license at http://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#include <filesystem>
+#include <span>
+#include <stdexcept>
+#include <type_traits>
+#include <cstdint>
+#include <cstddef>
+
+// A binary file of simulated equity price scenarios, so that one set of paths
+// can be generated once and then priced against by any number of valuations,
+// in any number of processes.  The file is memory-mapped read-only, so the
+// processes share the operating system's cached pages, and the prices are
+// read in place, without a copy.
+//
+// The file is a ScenarioHeader, followed by the prices as a column-major
+// num_scenarios x num_time_steps matrix: the prices of all scenarios at time
+// step 1, then at step 2, and so on up to expiration.  (The spot, at step 0, is
+// in the header.)  This layout lets a valuation check a barrier one step at a
+// time across a block of scenarios, with contiguous loads.  Values are in the
+// native byte order (little-endian on all supported platforms).
+
+enum class ScenarioValueType : std::uint32_t
+{
+	float64 = 0,
+	float32 = 1			// Half the size, at single precision
+};
+
+struct ScenarioHeader
+{
+	char magic[8];						// "MCSCENAR"
+	std::uint32_t version;
+	ScenarioValueType value_type;
+	std::uint64_t num_scenarios;
+	std::uint64_t num_time_steps;
+	std::uint64_t seed;					// Scenario i was drawn from Philox4x32{seed, i}
+
+	// The EquityPriceGenerator parameters:
+	double spot;
+	double time_to_expiration;
+	double volatility;
+	double rf_rate;
+	double div_rate;
+
+	std::byte reserved[48];				// Pads the header to 128 bytes, so that the
+										// prices are aligned for vector loads
+};
+
+static_assert(sizeof(ScenarioHeader) == 128);
+
+// Simulates num_scenarios paths with EquityPriceGenerator, scenario i drawn from
+// the stream Philox4x32{seed, i} as in MCOptionValuation, and writes them to
+// file_name.  Blocks of paths are generated and written one at a time, so the
+// memory used does not grow with num_scenarios.  Throws std::runtime_error if
+// the file cannot be written:
+void write_scenario_file(const std::filesystem::path& file_name, double spot,
+	int num_time_steps, double time_to_expiration, double volatility, double rf_rate,
+	double div_rate, std::uint64_t num_scenarios, std::uint64_t seed,
+	ScenarioValueType value_type = ScenarioValueType::float64);
+
+// Read-only memory map of a scenario file.  The constructor checks the header
+// and the file size, and throws std::runtime_error if the file cannot be
+// mapped or is not a valid scenario file:
+class ScenarioFile
+{
+public:
+	explicit ScenarioFile(const std::filesystem::path& file_name);
+	~ScenarioFile();
+
+	ScenarioFile(const ScenarioFile&) = delete;
+	ScenarioFile& operator =(const ScenarioFile&) = delete;
+	ScenarioFile(ScenarioFile&& rhs) noexcept;
+	ScenarioFile& operator =(ScenarioFile&& rhs) noexcept;
+
+	const ScenarioHeader& header() const;
+
+	// The prices of all scenarios at time step k, for k = 1, ..., num_time_steps.
+	// T must be double for a float64 file, and float for a float32 file:
+	template<typename T>
+	std::span<const T> prices_at_step(std::size_t k) const;
+
+private:
+	const std::byte* data_{nullptr};
+	std::size_t size_{0};
+
+	void unmap_() noexcept;
+};
+
+template<typename T>
+std::span<const T> ScenarioFile::prices_at_step(std::size_t k) const
+{
+	static_assert(std::is_same_v<T, double> || std::is_same_v<T, float>);
+	constexpr ScenarioValueType value_type = std::is_same_v<T, double>
+		? ScenarioValueType::float64 : ScenarioValueType::float32;
+
+	const ScenarioHeader& hdr = header();
+	if (hdr.value_type != value_type)
+	{
+		throw std::invalid_argument{"ScenarioFile::prices_at_step: wrong value type"};
+	}
+	if (k < 1 || k > hdr.num_time_steps)
+	{
+		throw std::invalid_argument{"ScenarioFile::prices_at_step: no such time step"};
+	}
+
+	const auto* prices = reinterpret_cast<const T*>(data_ + sizeof(ScenarioHeader));
+	return std::span<const T>{prices + (k - 1) * hdr.num_scenarios, hdr.num_scenarios};
+}
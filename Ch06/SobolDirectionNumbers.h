@@ -0,0 +1,20 @@
+/*
+ * This file is licensed under the Mozilla Public License, v. 2.0.
+ * You can obtain a copy of the license at http://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+// Joe & Kuo's direction numbers (new-joe-kuo-6.21201) for dimensions 2 to
+// joe_kuo_dimensions of a Sobol sequence.  The primitive polynomial of
+// dimension d is joe_kuo_polynomials[d - 2], with the coefficient of x^i in
+// bit i, so that its degree s and interior coefficients a of the table are
+// 2^s + 2a + 1.  Its initial values m_1, ..., m_s follow those of the earlier
+// dimensions in joe_kuo_initial_values.
+inline constexpr std::size_t joe_kuo_dimensions = 1024;
+
+extern const std::uint16_t joe_kuo_polynomials[joe_kuo_dimensions - 1];
+extern const std::uint16_t joe_kuo_initial_values[];
@@ -0,0 +1,221 @@
+/*
+ * This file is licensed under the Mozilla Public License, v. 2.0.
+ * You can obtain a copy of the license at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "SobolSequence.h"
+#include "SobolDirectionNumbers.h"
+#include "Philox.h"
+
+#include <array>
+#include <limits>
+#include <bit>
+#include <algorithm>
+#include <stdexcept>
+
+namespace
+{
+	// Product of polynomials over GF(2) (bit i = coefficient of x^i),
+	// reduced modulo poly, of degree deg:
+	std::uint64_t mul_mod(std::uint64_t a, std::uint64_t b, std::uint64_t poly, unsigned deg)
+	{
+		std::uint64_t result = 0;
+		while (b != 0)
+		{
+			if (b & 1) result ^= a;
+			b >>= 1;
+			a <<= 1;
+			if (a & (std::uint64_t{1} << deg)) a ^= poly;
+		}
+		return result;
+	}
+
+	// x^e modulo poly:
+	std::uint64_t pow_x_mod(std::uint64_t e, std::uint64_t poly, unsigned deg)
+	{
+		std::uint64_t result = 1, base = (deg == 1) ? (poly & 1) : 2;	// x mod poly
+		for (; e != 0; e >>= 1)
+		{
+			if (e & 1) result = mul_mod(result, base, poly, deg);
+			base = mul_mod(base, base, poly, deg);
+		}
+		return result;
+	}
+
+	// A polynomial of degree deg is primitive iff x has multiplicative order
+	// 2^deg - 1 modulo the polynomial:
+	bool is_primitive(std::uint64_t poly, unsigned deg)
+	{
+		const std::uint64_t order = (std::uint64_t{1} << deg) - 1;
+		if (pow_x_mod(order, poly, deg) != 1) return false;
+
+		std::uint64_t n = order;
+		for (std::uint64_t q = 2; q * q <= n; ++q)
+		{
+			if (n % q != 0) continue;
+			if (pow_x_mod(order / q, poly, deg) == 1) return false;
+			while (n % q == 0) n /= q;
+		}
+		return n == 1 || pow_x_mod(order / n, poly, deg) != 1;	// Last prime factor
+	}
+
+}
+
+SobolSequence::SobolSequence(std::size_t dimensions) :
+	dimensions_{dimensions}, directions_(dimensions * bits_), shifts_(dimensions)
+{
+	if (dimensions == 0)
+	{
+		throw std::invalid_argument{"SobolSequence: dimensions must be positive"};
+	}
+
+	// First dimension: m_k = 1 for all k (van der Corput):
+	for (int k = 0; k < bits_; ++k)
+	{
+		directions_[k] = std::uint32_t{1} << (bits_ - 1 - k);
+	}
+
+	// Dimensions 2 to joe_kuo_dimensions, from Joe & Kuo's table:
+	std::size_t dim = 1;
+	const std::uint16_t* init = joe_kuo_initial_values;
+	std::array<std::uint32_t, bits_> m{};
+	for (; dim < std::min(dimensions_, joe_kuo_dimensions); ++dim)
+	{
+		const std::uint32_t poly = joe_kuo_polynomials[dim - 1];
+		const unsigned s = static_cast<unsigned>(std::bit_width(poly)) - 1;
+		std::copy_n(init, s, m.begin());
+		init += s;
+		set_directions_(dim, s, (poly >> 1) & ((std::uint32_t{1} << (s - 1)) - 1),
+			std::span{m}.first(s));
+	}
+
+	// Any further dimensions use the next primitive polynomials, in the same
+	// order as Joe & Kuo (by degree, then by the interior coefficients a):
+	const std::uint64_t last_poly = joe_kuo_polynomials[joe_kuo_dimensions - 2];
+	Philox4x32 rng{0x5eed5eedULL, 0};
+	for (unsigned s = static_cast<unsigned>(std::bit_width(last_poly)) - 1; dim < dimensions_; ++s)
+	{
+		for (std::uint32_t a = 0; a < (std::uint32_t{1} << (s - 1)) && dim < dimensions_; ++a)
+		{
+			const std::uint64_t poly = (std::uint64_t{1} << s) | (std::uint64_t{a} << 1) | 1;
+			if (poly <= last_poly || !is_primitive(poly, s)) continue;
+
+			for (unsigned k = 0; k < s; ++k)	// Odd, and less than 2^(k + 1)
+			{
+				m[k] = static_cast<std::uint32_t>(rng() & ((std::uint64_t{1} << (k + 1)) - 1)) | 1;
+			}
+			set_directions_(dim, s, a, std::span{m}.first(s));
+			++dim;
+		}
+	}
+}
+
+SobolSequence::SobolSequence(std::size_t dimensions, std::istream& direction_numbers) :
+	dimensions_{dimensions}, directions_(dimensions * bits_), shifts_(dimensions)
+{
+	if (dimensions == 0)
+	{
+		throw std::invalid_argument{"SobolSequence: dimensions must be positive"};
+	}
+
+	for (int k = 0; k < bits_; ++k)
+	{
+		directions_[k] = std::uint32_t{1} << (bits_ - 1 - k);
+	}
+
+	direction_numbers.ignore(std::numeric_limits<std::streamsize>::max(), '\n');	// Header
+
+	std::vector<std::uint32_t> m;
+	for (std::size_t dim = 1; dim < dimensions_; ++dim)
+	{
+		std::size_t d{0};
+		unsigned s{0};
+		std::uint32_t a{0};
+		if (!(direction_numbers >> d >> s >> a) || s == 0 || s >= bits_)
+		{
+			throw std::runtime_error{"SobolSequence: too few dimensions in direction number file"};
+		}
+
+		m.resize(s);
+		for (auto& m_k : m)
+		{
+			direction_numbers >> m_k;
+		}
+		if (!direction_numbers)
+		{
+			throw std::runtime_error{"SobolSequence: bad line in direction number file"};
+		}
+		set_directions_(dim, s, a, m);
+	}
+}
+
+std::size_t SobolSequence::dimensions() const
+{
+	return dimensions_;
+}
+
+void SobolSequence::randomize(std::uint64_t seed)
+{
+	Philox4x32 rng{seed, 0};
+	for (auto& shift : shifts_)
+	{
+		shift = static_cast<std::uint32_t>(rng() >> 32);
+	}
+}
+
+void SobolSequence::point(std::uint64_t n, std::span<double> u) const
+{
+	if (u.size() != dimensions_)
+	{
+		throw std::invalid_argument{"SobolSequence: point must hold dimensions() values"};
+	}
+	if (n > std::numeric_limits<std::uint32_t>::max())
+	{
+		throw std::out_of_range{"SobolSequence: at most 2^32 points"};
+	}
+
+	// Bits of the Gray code of n select the direction numbers to combine:
+	std::array<int, bits_> set_bits{};
+	int num_set = 0;
+	for (std::uint64_t gray = n ^ (n >> 1); gray != 0; gray &= gray - 1)
+	{
+		set_bits[num_set++] = std::countr_zero(gray);
+	}
+
+	constexpr double scale = 0x1.0p-32;
+	for (std::size_t dim = 0; dim < dimensions_; ++dim)
+	{
+		const std::uint32_t* v = directions_.data() + dim * bits_;
+		std::uint32_t x = shifts_[dim];
+		for (int j = 0; j < num_set; ++j)
+		{
+			x ^= v[set_bits[j]];
+		}
+		u[dim] = (static_cast<double>(x) + 0.5) * scale;
+	}
+}
+
+void SobolSequence::set_directions_(std::size_t dim, unsigned s, std::uint32_t a,
+	std::span<const std::uint32_t> m)
+{
+	// m_k = 2 a_1 m_(k-1) ^ 4 a_2 m_(k-2) ^ ... ^ 2^s m_(k-s) ^ m_(k-s),
+	// and direction number k is m_k / 2^k, held as a 32-bit fraction:
+	std::array<std::uint64_t, bits_> mk{};
+	for (int k = 0; k < bits_; ++k)
+	{
+		if (static_cast<unsigned>(k) < s)
+		{
+			mk[k] = m[k];
+		}
+		else
+		{
+			std::uint64_t next = mk[k - s] ^ (mk[k - s] << s);
+			for (unsigned j = 1; j < s; ++j)
+			{
+				if ((a >> (s - 1 - j)) & 1) next ^= mk[k - j] << j;
+			}
+			mk[k] = next;
+		}
+		directions_[dim * bits_ + k] = static_cast<std::uint32_t>(mk[k] << (bits_ - 1 - k));
+	}
+}
@@ -0,0 +1,61 @@
+/*
+ * This file is licensed under the Mozilla Public License, v. 2.0.
+ * You can obtain a copy of the license at http://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#include <vector>
+#include <span>
+#include <istream>
+#include <cstdint>
+#include <cstddef>
+
+// Sobol low-discrepancy sequence in base 2 (Bratley & Fox, Joe & Kuo), with
+// 32-bit direction numbers, so that up to 2^32 points may be drawn.
+//
+// Points are indexed in Gray-code order: point n is the XOR of the direction
+// numbers selected by the bits of n ^ (n >> 1).  Any point can therefore be
+// computed directly from its index, without generating those before it, so
+// blocks of Monte Carlo scenarios can still be simulated independently.
+class SobolSequence
+{
+public:
+	// Built-in direction numbers: the first dimension is the van der Corput
+	// sequence, and dimensions 2 to joe_kuo_dimensions (1024) use Joe & Kuo's
+	// table (see SobolDirectionNumbers.h).  Any further dimensions use the next
+	// primitive polynomials (in increasing degree) with fixed pseudo-random
+	// initial values.  These are valid Sobol direction numbers, but have not
+	// been optimized for their two-dimensional projections, so beyond 1024
+	// dimensions, load the full Joe & Kuo table with the constructor below:
+	explicit SobolSequence(std::size_t dimensions);
+
+	// Direction numbers read from a file in the format of Joe & Kuo's
+	// new-joe-kuo-6.21201 (a header line, then "d s a m_1 ... m_s" for
+	// dimensions 2, 3, ...):
+	SobolSequence(std::size_t dimensions, std::istream& direction_numbers);
+
+	std::size_t dimensions() const;
+
+	// Applies a random digital shift (each coordinate XORed with a fixed random
+	// word), derived from the seed.  The shifted points keep their low-discrepancy
+	// structure, while the estimates from different seeds are independent:
+	void randomize(std::uint64_t seed);
+
+	// Writes point n into u, which must hold dimensions() values.  Coordinates
+	// are mapped to the midpoints of their 2^-32 intervals, so lie strictly
+	// inside (0, 1), as required by inverse_normal_cdf(.):
+	void point(std::uint64_t n, std::span<double> u) const;
+
+private:
+	static constexpr int bits_ = 32;
+
+	std::size_t dimensions_;
+	std::vector<std::uint32_t> directions_;		// bits_ direction numbers per dimension
+	std::vector<std::uint32_t> shifts_;			// Digital shift per dimension (0: none)
+
+	// Fills the direction numbers of dimension dim from the primitive polynomial
+	// of degree s with interior coefficients a, and initial values m_1, ..., m_s:
+	void set_directions_(std::size_t dim, unsigned s, std::uint32_t a,
+		std::span<const std::uint32_t> m);
+};
@@ -0,0 +1,124 @@
+/*
+ * This file is licensed under the Mozilla Public License, v. 2.0.
+ * You can obtain a copy of the license at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "ThreadPool.h"
+
+#include <utility>		// std::move
+#include <algorithm>	// std::max
+
+namespace
+{
+	// Identifies the pool (and queue) owned by the current thread, if any:
+	thread_local const ThreadPool* tl_pool = nullptr;
+	thread_local std::size_t tl_queue_idx = 0;
+}
+
+ThreadPool::ThreadPool(unsigned num_threads)
+{
+	num_threads = std::max(num_threads, 1u);	// hardware_concurrency() may return 0
+
+	queues_.reserve(num_threads);
+	for (unsigned i = 0; i < num_threads; ++i)
+	{
+		queues_.push_back(std::make_unique<WorkQueue>());
+	}
+
+	workers_.reserve(num_threads);
+	for (unsigned i = 0; i < num_threads; ++i)
+	{
+		workers_.emplace_back(&ThreadPool::worker_loop_, this, i);
+	}
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard lk{sleep_mtx_};
+		stop_ = true;
+	}
+	work_cv_.notify_all();
+
+	for (auto& w : workers_)
+	{
+		w.join();
+	}
+}
+
+unsigned ThreadPool::size() const
+{
+	return static_cast<unsigned>(workers_.size());
+}
+
+void ThreadPool::submit_(std::function<void()> task)
+{
+	// Tasks spawned from a worker go onto its own queue (and will most likely
+	// be run by it, while the data is still in cache); external submissions
+	// are dealt out round-robin.
+	std::size_t idx = (tl_pool == this) ? tl_queue_idx
+		: next_queue_.fetch_add(1, std::memory_order_relaxed) % queues_.size();
+
+	{
+		std::lock_guard lk{queues_[idx]->mtx};
+		queues_[idx]->tasks.push_back(std::move(task));
+	}
+	{
+		std::lock_guard lk{sleep_mtx_};
+		++queued_;
+	}
+	work_cv_.notify_one();
+}
+
+bool ThreadPool::try_run_task_()
+{
+	const std::size_t num_queues = queues_.size();
+	const bool is_worker = (tl_pool == this);
+	const std::size_t home = is_worker ? tl_queue_idx : 0;
+
+	std::function<void()> task;
+
+	// Own queue first (LIFO), then steal from the others (FIFO):
+	if (is_worker)
+	{
+		std::lock_guard lk{queues_[home]->mtx};
+		auto& tasks = queues_[home]->tasks;
+		if (!tasks.empty())
+		{
+			task = std::move(tasks.back());
+			tasks.pop_back();
+		}
+	}
+
+	for (std::size_t k = is_worker ? 1 : 0; !task && k < num_queues; ++k)
+	{
+		auto& victim = *queues_[(home + k) % num_queues];
+		std::lock_guard lk{victim.mtx};
+		if (!victim.tasks.empty())
+		{
+			task = std::move(victim.tasks.front());
+			victim.tasks.pop_front();
+		}
+	}
+
+	if (!task) return false;
+
+	--queued_;
+	task();
+	return true;
+}
+
+void ThreadPool::worker_loop_(std::size_t idx)
+{
+	tl_pool = this;
+	tl_queue_idx = idx;
+
+	while (true)
+	{
+		if (try_run_task_()) continue;
+
+		std::unique_lock lk{sleep_mtx_};
+		work_cv_.wait(lk, [this] {return stop_ || queued_ > 0;});
+		if (stop_ && queued_ == 0) return;
+	}
+}
@@ -0,0 +1,165 @@
+/*
+ * This file is licensed under the Mozilla Public License, v. 2.0.
+ * You can obtain a copy of the license at http://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#include <vector>
+#include <deque>
+#include <memory>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <latch>
+#include <exception>
+#include <type_traits>
+#include <utility>
+#include <algorithm>		// std::min
+#include <cstddef>
+
+// A fixed-size work-stealing thread pool.  Each worker owns a task queue:
+// it pops work from the back of its own queue, and when that runs dry it
+// steals from the front of the other workers' queues.  The threads are
+// created once and reused, so a valuation submits a handful of chunks
+// rather than launching one std::async per scenario.
+class ThreadPool
+{
+public:
+	explicit ThreadPool(unsigned num_threads = std::thread::hardware_concurrency());
+	~ThreadPool();
+
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator =(const ThreadPool&) = delete;
+
+	unsigned size() const;
+
+	// Runs fn(0), fn(1), ..., fn(num_tasks - 1) on the pool and returns once all
+	// of them have completed.  The calling thread helps to execute queued tasks
+	// while it waits, so parallel_for(.) may also be called from inside a task.
+	// The first exception thrown by a task is rethrown here.
+	template<typename F>
+	void parallel_for(std::size_t num_tasks, F fn);
+
+private:
+	struct WorkQueue
+	{
+		std::mutex mtx;
+		std::deque<std::function<void()>> tasks;
+	};
+
+	void submit_(std::function<void()> task);
+	bool try_run_task_();
+	void worker_loop_(std::size_t idx);
+
+	std::vector<std::unique_ptr<WorkQueue>> queues_;
+	std::vector<std::thread> workers_;
+
+	std::mutex sleep_mtx_;
+	std::condition_variable work_cv_;
+	std::atomic<std::size_t> queued_{0};		// Tasks submitted but not yet taken
+	std::atomic<std::size_t> next_queue_{0};	// Round-robin target for external submits
+	bool stop_{false};
+};
+
+template<typename F>
+void ThreadPool::parallel_for(std::size_t num_tasks, F fn)
+{
+	if (num_tasks == 0) return;
+
+	std::latch done{static_cast<std::ptrdiff_t>(num_tasks)};
+	std::exception_ptr first_error;
+	std::mutex error_mtx;
+
+	for (std::size_t k = 0; k < num_tasks; ++k)
+	{
+		submit_([&fn, &done, &first_error, &error_mtx, k]
+			{
+				try
+				{
+					fn(k);
+				}
+				catch (...)
+				{
+					std::lock_guard lk{error_mtx};
+					if (!first_error) first_error = std::current_exception();
+				}
+				done.count_down();
+			});
+	}
+
+	// Help out rather than block; once nothing is left to take, the
+	// remaining tasks are already running on the workers.
+	while (!done.try_wait())
+	{
+		if (!try_run_task_())
+		{
+			done.wait();
+		}
+	}
+
+	if (first_error) std::rethrow_exception(first_error);
+}
+
+// Runs the blocks first_block, ..., last_block - 1 of a Monte Carlo run in
+// batches, one block per worker of pool (or one at a time if pool is null):
+// simulate(block) runs on the pool, and merge(block, result) is then called on
+// this thread for each block of the batch, in block order, so that a result
+// merged from the blocks does not depend on the pool.  The run stops early
+// when merge(.) returns false, or when out_of_time() is true after a batch; a
+// block other than the first of its batch is not started once out_of_time()
+// is true, and the batch is then merged up to that block.  Returns the block
+// after the last one merged:
+template<typename Simulate, typename Merge, typename OutOfTime>
+std::size_t run_blocks_in_order(ThreadPool* pool, std::size_t first_block,
+	std::size_t last_block, Simulate&& simulate, Merge&& merge, OutOfTime&& out_of_time)
+{
+	using Result = std::invoke_result_t<Simulate&, std::size_t>;
+
+	const std::size_t batch_size = pool ? std::size_t{pool->size()} : 1;
+	std::vector<Result> batch;
+	std::vector<char> simulated;
+	std::size_t next_block = first_block;
+	while (next_block < last_block)
+	{
+		const std::size_t n = std::min(batch_size, last_block - next_block);
+		batch.assign(n, Result{});
+		simulated.assign(n, 0);
+		auto run_block = [&](std::size_t k)
+			{
+				if (k > 0 && out_of_time()) return;
+				batch[k] = simulate(next_block + k);
+				simulated[k] = 1;
+			};
+
+		if (pool)
+		{
+			pool->parallel_for(n, run_block);
+		}
+		else
+		{
+			run_block(0);
+		}
+
+		for (std::size_t k = 0; k < n && simulated[k]; ++k)
+		{
+			if (!merge(next_block, std::move(batch[k]))) return next_block + 1;
+			++next_block;
+		}
+
+		if (out_of_time()) break;
+	}
+
+	return next_block;
+}
+
+// The same, for a run without a time limit:
+template<typename Simulate, typename Merge>
+std::size_t run_blocks_in_order(ThreadPool* pool, std::size_t first_block,
+	std::size_t last_block, Simulate&& simulate, Merge&& merge)
+{
+	return run_blocks_in_order(pool, first_block, last_block, simulate, merge,
+		[] {return false;});
+}
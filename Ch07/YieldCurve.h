@@ -7,6 +7,7 @@
 
 #include "ChronoDate.h"
 #include "DayCounts.h"
+#include <vector>
 
 // Yield Curve Abstract Base Class:
 class YieldCurve
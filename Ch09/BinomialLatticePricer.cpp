@@ -58,12 +58,16 @@ void BinomialLatticePricer::project_underlying_prices_(double spot)
 
 double BinomialLatticePricer::calculate_node_payoffs_(OptType opt_type)
 {
-	// Set the terminal nodes with payoffs at expiration: j = time_points_ - 1
-	for (int i = 0; i <= time_points_ - 1; ++i)
-	{
-		grid_[i][time_points_ - 1].payoff 
-			= opt_.option_payoff(grid_[i][time_points_ - 1].underlying);
-	}
+	// Set the terminal nodes with payoffs at expiration: j = time_points_ - 1.
+	// The payoff type is dispatched once for the column, not once per node:
+	opt_.visit_payoff([this](const auto& payoff)
+		{
+			for (int i = 0; i <= time_points_ - 1; ++i)
+			{
+				grid_[i][time_points_ - 1].payoff
+					= payoff.payoff(grid_[i][time_points_ - 1].underlying);
+			}
+		});
 
 	if (opt_type == OptType::American) 
 		american_payoffs_();
@@ -82,15 +86,19 @@ double BinomialLatticePricer::disc_expected_val_(int i, int j) const
 
 void BinomialLatticePricer::american_payoffs_()
 {
-	// Start from penultimate column prior to expiration: j = time_points_ - 2
-	for (int j = time_points_ - 2; j >= 0; --j)
-	{
-		for (int i = 0; i <= j; ++i)
+	// Start from penultimate column prior to expiration: j = time_points_ - 2.
+	// The payoff type is dispatched once, outside the backward induction:
+	opt_.visit_payoff([this](const auto& payoff)
 		{
-			grid_[i][j].payoff = std::max(disc_expected_val_(i, j),
-				opt_.option_payoff(grid_[i][j].underlying));
-		}
-	}
+			for (int j = time_points_ - 2; j >= 0; --j)
+			{
+				for (int i = 0; i <= j; ++i)
+				{
+					grid_[i][j].payoff = std::max(disc_expected_val_(i, j),
+						payoff.payoff(grid_[i][j].underlying));
+				}
+			}
+		});
 }
 
 void BinomialLatticePricer::european_payoffs_()
@@ -16,12 +16,9 @@
 // of a raw pointer and "virtual constructor" as seen in the C++03 version above.
 
 OptionInfo::OptionInfo(std::unique_ptr<Payoff> payoff, double time_to_exp) :
-	payoff_ptr_{std::move(payoff)}, time_to_exp_{time_to_exp} {}
+	payoff_{make_payoff_variant_(std::move(payoff))}, time_to_exp_{time_to_exp} {}
 
-double OptionInfo::option_payoff(double spot) const
-{
-	return payoff_ptr_->payoff(spot);
-}
+// option_payoff(.) is defined inline in OptionInfo.h.
 
 double OptionInfo::time_to_expiration() const
 {
@@ -31,14 +28,14 @@ double OptionInfo::time_to_expiration() const
 void OptionInfo::swap(OptionInfo& rhs) noexcept
 {
 	using std::swap;
-	swap(payoff_ptr_, rhs.payoff_ptr_);
+	swap(payoff_, rhs.payoff_);
 	swap(time_to_exp_, rhs.time_to_exp_);
 	//throw std::runtime_error{"Error:..."};	// Compiler warning, runtime error (for demonstration)
 }
 
 // Copy Constructor:
 OptionInfo::OptionInfo(const OptionInfo& rhs) :
-	payoff_ptr_{rhs.payoff_ptr_->clone()}, 
+	payoff_{rhs.visit_payoff([](const auto& payoff) { return make_payoff_variant_(payoff.clone()); })},
 	time_to_exp_{rhs.time_to_expiration()} {}
 
 // Copy Assignment:
@@ -46,4 +43,12 @@ OptionInfo& OptionInfo::operator =(const OptionInfo& rhs) noexcept
 {
 	OptionInfo{rhs}.swap(*this);
 	return *this;
+}
+
+// The final Payoff types are held by value; any other is kept behind its pointer:
+PayoffVariant OptionInfo::make_payoff_variant_(std::unique_ptr<Payoff> payoff)
+{
+	if (auto call = dynamic_cast<const CallPayoff*>(payoff.get())) return *call;
+	if (auto put = dynamic_cast<const PutPayoff*>(payoff.get())) return *put;
+	return payoff;
 }
\ No newline at end of file
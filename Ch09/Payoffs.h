@@ -5,6 +5,7 @@
 
 #pragma once
 #include <memory>
+#include <algorithm>
 
 // Payoff (C++11/C++14) -- from Ch 3
 
@@ -16,6 +17,10 @@ public:
 	virtual ~Payoff() = default;
 };
 
+// The payoff(.) functions of the final classes below are defined inline, so
+// that a call through an object of the derived type (eg, when OptionInfo
+// dispatches with std::visit) is not virtual and can be inlined into a loop.
+
 class CallPayoff final : public Payoff
 {
 public:
@@ -28,6 +33,11 @@ private:
 	double strike_;
 };
 
+inline double CallPayoff::payoff(double price) const
+{
+	return std::max(price - strike_, 0.0);
+}
+
 class PutPayoff final : public Payoff
 {
 public:
@@ -39,4 +49,9 @@ public:
 
 private:
 	double strike_;
-};
\ No newline at end of file
+};
+
+inline double PutPayoff::payoff(double price) const
+{
+	return std::max(strike_ - price, 0.0);
+}
\ No newline at end of file
@@ -0,0 +1,214 @@
+/*
+ * This file is licensed under the Mozilla Public License, v. 2.0.
+ * You can obtain a copy of the license at http://mozilla.org/MPL/2.0/.
+ */
+
+// Runs the option book of euro_portfolio_examples(.) in Ch06 as shards in
+// separate processes, and merges them (see Ch06/MCShard.h):
+//
+//	MCShardRunner run shard num_shards file [options]
+//		Runs shard `shard` (0, 1, ..., num_shards - 1) of the paths, and writes
+//		its statistics to `file`.  The shards can be run anywhere, in any order.
+//	MCShardRunner merge file...
+//		Merges the shard files of a run, and prints the price of each option.
+//	MCShardRunner launch num_shards [options]
+//		Starts num_shards local processes of `run`, merges their files, and
+//		checks the result against a single-process run, bit for bit.
+//
+// The options are --paths n (default: 1'000'000), --seed n (default: 42), and,
+// for launch, --dir path, the directory for the shard files (default: the
+// temporary directory).
+//
+// Build with Ch06/MCPortfolioValuation.cpp, MCCheckpoint.cpp, MCShard.cpp,
+// NormalSamplers.cpp, OptionInfo.cpp, Payoffs.cpp, RunningStats.cpp, and
+// ThreadPool.cpp.
+
+#include "../Ch06/MCPortfolioValuation.h"
+#include "../Ch06/MCShard.h"
+#include "../Ch06/ThreadPool.h"
+#include "../Ch06/Payoffs.h"
+
+#include <iostream>
+#include <format>
+#include <filesystem>
+#include <future>
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstdlib>		// std::system
+#include <exception>
+#include <stdexcept>
+
+namespace
+{
+	constexpr double spot = 100.0;
+
+	struct RunOptions
+	{
+		int num_scenarios{1'000'000};
+		unsigned seed{42};
+		std::filesystem::path dir{std::filesystem::temp_directory_path()};
+	};
+
+	// Positional arguments are left in `args`, the options in the return value:
+	RunOptions parse_options(std::vector<std::string>& args)
+	{
+		RunOptions options;
+		std::vector<std::string> positional;
+		for (std::size_t i = 0; i < args.size(); ++i)
+		{
+			if (args[i].starts_with("--") && i + 1 == args.size())
+			{
+				throw std::invalid_argument{"missing value for " + args[i]};
+			}
+
+			if (args[i] == "--paths") options.num_scenarios = std::stoi(args[++i]);
+			else if (args[i] == "--seed") options.seed = static_cast<unsigned>(std::stoul(args[++i]));
+			else if (args[i] == "--dir") options.dir = args[++i];
+			else if (args[i].starts_with("--")) throw std::invalid_argument{"unknown option " + args[i]};
+			else positional.push_back(args[i]);
+		}
+
+		args = std::move(positional);
+		return options;
+	}
+
+	// The book of euro_portfolio_examples(.): calls and up-and-out calls
+	// across strikes and expirations:
+	MCPortfolioValuation make_book()
+	{
+		std::vector<OptionInfo> opts;
+		std::vector<BarrierSpec> barriers;
+		for (double time_to_exp : {0.25, 0.5, 1.0})
+		{
+			for (double strike : {90.0, 100.0, 110.0})
+			{
+				opts.emplace_back(std::make_unique<CallPayoff>(strike), time_to_exp);
+				barriers.push_back(BarrierSpec{});
+				opts.emplace_back(std::make_unique<CallPayoff>(strike), time_to_exp);
+				barriers.push_back(BarrierSpec{BarrierType::up_and_out, 130.0});
+			}
+		}
+
+		MCPortfolioValuation book{std::move(opts), barriers, 24, 0.25, 0.05, 0.02};
+		book.set_barrier_monitoring(BarrierMonitoring::brownian_bridge);
+		return book;
+	}
+
+	void run_shard(unsigned shard, unsigned num_shards, const std::filesystem::path& file,
+		const RunOptions& options)
+	{
+		MCPortfolioValuation book = make_book();
+		const auto [first_path, last_path] = shard_paths(options.num_scenarios, shard, num_shards);
+
+		ThreadPool pool{};
+		MCShard result = book.calc_prices_shard(spot, options.num_scenarios, options.seed,
+			first_path, last_path, pool);
+		write_shard_file(file, result);
+
+		std::cout << std::format("Shard {} of {}: paths [{}, {}) in {:.1f} msec\n",
+			shard, num_shards, first_path, last_path, result.elapsed);
+	}
+
+	std::vector<MCResult> merge_files(const std::vector<std::filesystem::path>& files)
+	{
+		std::vector<MCShard> shards;
+		for (const auto& file : files)
+		{
+			shards.push_back(read_shard_file(file));
+		}
+		return make_book().merge_shards(std::move(shards));
+	}
+
+	void print_results(const std::vector<MCResult>& results)
+	{
+		for (std::size_t k = 0; k < results.size(); ++k)
+		{
+			std::cout << std::format("Option {:>2}: {:.6f} ({:.6f})\n",
+				k, results[k].price, results[k].std_error);
+		}
+	}
+
+	int launch(const std::string& program, unsigned num_shards, const RunOptions& options)
+	{
+		std::vector<std::filesystem::path> files;
+		std::vector<std::future<int>> processes;
+		for (unsigned shard = 0; shard < num_shards; ++shard)
+		{
+			files.push_back(options.dir / std::format("mc_shard_{}_of_{}.bin", shard, num_shards));
+			const std::string command = std::format("\"{}\" run {} {} \"{}\" --paths {} --seed {}",
+				program, shard, num_shards, files.back().string(), options.num_scenarios, options.seed);
+
+			// One thread waits on each process, so the processes run concurrently:
+			processes.push_back(std::async(std::launch::async,
+				[command] {return std::system(command.c_str());}));
+		}
+
+		for (unsigned shard = 0; shard < num_shards; ++shard)
+		{
+			if (processes[shard].get() != 0)
+			{
+				throw std::runtime_error{std::format("shard {} failed", shard)};
+			}
+		}
+
+		const std::vector<MCResult> merged = merge_files(files);
+		for (const auto& file : files)
+		{
+			std::filesystem::remove(file);
+		}
+
+		ThreadPool pool{};
+		MCPortfolioValuation book = make_book();
+		const std::vector<MCResult> single = book.calc_prices(spot, options.num_scenarios,
+			options.seed, pool);
+
+		print_results(merged);
+
+		bool identical = true;
+		for (std::size_t k = 0; k < merged.size(); ++k)
+		{
+			identical = identical && merged[k].price == single[k].price
+				&& merged[k].std_error == single[k].std_error && merged[k].n_paths == single[k].n_paths;
+		}
+		std::cout << std::format("{} shards: {:.1f} msec in all; single process: {:.1f} msec\n",
+			num_shards, merged.front().elapsed, single.front().elapsed);
+		std::cout << (identical ? "Merged results are identical to the single-process run\n"
+			: "Merged results DIFFER from the single-process run\n");
+		return identical ? 0 : 1;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	try
+	{
+		std::vector<std::string> args(argv + 1, argv + argc);
+		const RunOptions options = parse_options(args);
+
+		if (args.size() == 4 && args[0] == "run")
+		{
+			run_shard(std::stoul(args[1]), std::stoul(args[2]), args[3], options);
+			return 0;
+		}
+		if (args.size() >= 2 && args[0] == "merge")
+		{
+			print_results(merge_files({args.begin() + 1, args.end()}));
+			return 0;
+		}
+		if (args.size() == 2 && args[0] == "launch")
+		{
+			return launch(argv[0], std::stoul(args[1]), options);
+		}
+
+		throw std::invalid_argument{"no such command"};
+	}
+	catch (const std::exception& e)
+	{
+		std::cerr << e.what() << "\n"
+			<< "Usage: " << argv[0] << " run shard num_shards file [--paths n] [--seed n]\n"
+			<< "       " << argv[0] << " merge file...\n"
+			<< "       " << argv[0] << " launch num_shards [--paths n] [--seed n] [--dir path]\n";
+		return 1;
+	}
+}